@@ -0,0 +1,284 @@
+#include "affixdictionary.h"
+
+#include <QFile>
+#include <QHash>
+#include <QRegularExpression>
+#include <QVarLengthArray>
+#include <algorithm>
+
+namespace {
+
+using StemBuffer = QVarLengthArray<QChar, 64>;
+
+QStringView viewOf(const StemBuffer& buffer)
+{
+    return QStringView(buffer.data(), buffer.size());
+}
+
+QString affixText(const QString& field)
+{
+    // "0" stands for nothing, continuation flags after a '/' aren't supported
+    auto text = field.section('/', 0, 0);
+    return text == "0" ? QString() : text.toLower();
+}
+
+}
+
+AffixDictionary AffixDictionary::fromFiles(const QString& affixFileName, const QString& dictionaryFileName)
+{
+    QFile affixFile(affixFileName);
+    QFile dictionaryFile(dictionaryFileName);
+    if (!affixFile.open(QFile::ReadOnly) || !dictionaryFile.open(QFile::ReadOnly))
+        return {};
+
+    auto data = QSharedPointer<Data>::create();
+    auto flagType = FlagType::Character;
+    QHash<quint32, bool> crossProducts;
+    static const QRegularExpression whitespace("\\s+");
+
+    while (!affixFile.atEnd()) {
+        auto line = QString::fromUtf8(affixFile.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        auto fields = line.split(whitespace, Qt::SkipEmptyParts);
+        auto& directive = fields[0];
+
+        if (directive == "FLAG" && fields.size() > 1) {
+            if (fields[1] == "long")
+                flagType = FlagType::Long;
+            else if (fields[1] == "num")
+                flagType = FlagType::Number;
+        }
+        else if (directive == "NEEDAFFIX" && fields.size() > 1) {
+            auto flags = parseFlags(fields[1], flagType);
+            if (!flags.isEmpty())
+                data->needAffixFlag = flags.first();
+        }
+        else if ((directive == "PFX" || directive == "SFX") && fields.size() >= 4) {
+            auto flags = parseFlags(fields[1], flagType);
+            if (flags.isEmpty())
+                continue;
+
+            // Header: flag, cross product and number of rules
+            if (fields.size() == 4 && (fields[2] == "Y" || fields[2] == "N")) {
+                crossProducts.insert(flags.first(), fields[2] == "Y");
+                continue;
+            }
+
+            Affix affix;
+            affix.flag = flags.first();
+            affix.crossProduct = crossProducts.value(affix.flag);
+            affix.strip = affixText(fields[2]);
+            affix.append = affixText(fields[3]);
+            if (fields.size() > 4)
+                affix.condition = parseCondition(fields[4]);
+
+            (directive == "PFX" ? data->prefixes : data->suffixes).append(affix);
+        }
+    }
+
+    auto sortAffixes = [](QVector<Affix>& affixes, QVector<qsizetype>& lengths) {
+        std::sort(affixes.begin(), affixes.end(),
+                  [](const Affix& a, const Affix& b) { return a.append < b.append; });
+        for (auto& affix: std::as_const(affixes))
+            lengths.append(affix.append.size());
+        std::sort(lengths.begin(), lengths.end());
+        lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+    };
+    sortAffixes(data->prefixes, data->prefixLengths);
+    sortAffixes(data->suffixes, data->suffixLengths);
+
+    // Homonyms are listed once per meaning, their flags are merged
+    QHash<QString, QVector<quint32>> stemFlags;
+    bool firstLine = true;
+    while (!dictionaryFile.atEnd()) {
+        auto line = QString::fromUtf8(dictionaryFile.readLine()).trimmed();
+        if (firstLine) {
+            firstLine = false;
+            bool isCount = false;
+            line.toInt(&isCount);
+            if (isCount)
+                continue;
+        }
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        auto entry = line.section(whitespace, 0, 0);
+        auto separator = entry.indexOf('/');
+        auto stem = (separator == -1 ? entry : entry.left(separator)).toLower();
+        if (stem.isEmpty())
+            continue;
+
+        auto& flags = stemFlags[stem];
+        if (separator != -1)
+            flags.append(parseFlags(QStringView(entry).sliced(separator + 1), flagType));
+    }
+
+    data->stems = WordList::fromWords(stemFlags.keys());
+    data->flagOffsets.reserve(data->stems.size() + 1);
+    for (qsizetype i = 0; i < data->stems.size(); i++) {
+        auto flags = stemFlags.value(data->stems.at(i).toString());
+        std::sort(flags.begin(), flags.end());
+        flags.erase(std::unique(flags.begin(), flags.end()), flags.end());
+
+        data->flagOffsets.append(data->flags.size());
+        data->flags.append(flags);
+    }
+    data->flagOffsets.append(data->flags.size());
+
+    AffixDictionary dictionary;
+    dictionary.d = data;
+    return dictionary;
+}
+
+bool AffixDictionary::contains(QStringView word) const
+{
+    if (isEmpty() || word.isEmpty())
+        return false;
+
+    if (isStem(word, 0) || containsWithSuffix(word, nullptr))
+        return true;
+
+    StemBuffer stem;
+    for (auto length: d->prefixLengths) {
+        if (length > word.size())
+            break;
+
+        auto range = affixesAdding(d->prefixes, word.first(length));
+        for (auto prefix = range.first; prefix != range.second; ++prefix) {
+            stem.clear();
+            stem.append(prefix->strip.constData(), prefix->strip.size());
+            stem.append(word.sliced(length).data(), word.size() - length);
+            if (stem.isEmpty() || !conditionMatches(prefix->condition, viewOf(stem), false))
+                continue;
+
+            if (isStem(viewOf(stem), prefix->flag)
+                || (prefix->crossProduct && containsWithSuffix(viewOf(stem), &*prefix)))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+bool AffixDictionary::containsWithSuffix(QStringView word, const Affix* prefix) const
+{
+    StemBuffer stem;
+    for (auto length: d->suffixLengths) {
+        if (length > word.size())
+            break;
+
+        auto range = affixesAdding(d->suffixes, word.last(length));
+        for (auto suffix = range.first; suffix != range.second; ++suffix) {
+            if (prefix && !suffix->crossProduct)
+                continue;
+
+            stem.clear();
+            stem.append(word.data(), word.size() - length);
+            stem.append(suffix->strip.constData(), suffix->strip.size());
+            if (stem.isEmpty() || !conditionMatches(suffix->condition, viewOf(stem), true))
+                continue;
+
+            if (isStem(viewOf(stem), suffix->flag, prefix ? prefix->flag : 0))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+std::pair<AffixDictionary::AffixIterator, AffixDictionary::AffixIterator>
+AffixDictionary::affixesAdding(const QVector<Affix>& affixes, QStringView text)
+{
+    auto begin = std::lower_bound(affixes.cbegin(), affixes.cend(), text,
+                                  [](const Affix& affix, QStringView text) { return QStringView(affix.append) < text; });
+    auto end = std::upper_bound(begin, affixes.cend(), text,
+                                [](QStringView text, const Affix& affix) { return text < QStringView(affix.append); });
+    return {begin, end};
+}
+
+bool AffixDictionary::isStem(QStringView word, quint32 flag, quint32 secondFlag) const
+{
+    auto i = d->stems.lowerBound(word);
+    if (i >= d->stems.size() || d->stems.at(i) != word)
+        return false;
+
+    // A bare stem, unless it is only valid with an affix
+    if (!flag)
+        return !d->needAffixFlag || !hasFlag(i, d->needAffixFlag);
+
+    return hasFlag(i, flag) && (!secondFlag || hasFlag(i, secondFlag));
+}
+
+bool AffixDictionary::hasFlag(qsizetype stem, quint32 flag) const
+{
+    auto begin = d->flags.cbegin() + d->flagOffsets[stem];
+    auto end = d->flags.cbegin() + d->flagOffsets[stem + 1];
+    return std::binary_search(begin, end, flag);
+}
+
+QVector<quint32> AffixDictionary::parseFlags(QStringView text, FlagType type)
+{
+    QVector<quint32> flags;
+
+    switch (type) {
+    case FlagType::Character:
+        for (auto character: text)
+            flags.append(character.unicode());
+        break;
+    case FlagType::Long:
+        for (qsizetype i = 0; i + 1 < text.size(); i += 2)
+            flags.append(quint32(text[i].unicode()) << 16 | text[i + 1].unicode());
+        break;
+    case FlagType::Number:
+        for (auto number: text.split(u',')) {
+            bool isNumber = false;
+            auto flag = number.toUInt(&isNumber);
+            if (isNumber && flag)
+                flags.append(flag);
+        }
+        break;
+    }
+
+    return flags;
+}
+
+QVector<AffixDictionary::ConditionCharacter> AffixDictionary::parseCondition(QStringView text)
+{
+    QVector<ConditionCharacter> condition;
+    if (text == u".")
+        return condition;
+
+    for (qsizetype i = 0; i < text.size(); i++) {
+        ConditionCharacter character;
+        if (text[i] == u'[') {
+            auto end = text.indexOf(u']', i);
+            if (end == -1)
+                end = text.size();
+            auto characters = text.sliced(i + 1, end - i - 1);
+            character.negated = characters.startsWith(u'^');
+            character.characters = (character.negated ? characters.sliced(1) : characters).toString();
+            i = end;
+        }
+        else if (text[i] != u'.') {
+            character.characters = text[i];
+        }
+        condition.append(character);
+    }
+
+    return condition;
+}
+
+bool AffixDictionary::conditionMatches(const QVector<ConditionCharacter>& condition, QStringView stem, bool atEnd)
+{
+    if (condition.size() > stem.size())
+        return false;
+
+    auto offset = atEnd ? stem.size() - condition.size() : 0;
+    for (qsizetype i = 0; i < condition.size(); i++) {
+        if (!condition[i].matches(stem[offset + i]))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "wordlist.h"
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <utility>
+
+/**
+ * @class AffixDictionary
+ * @brief Hunspell style stem and affix dictionary, checking inflected words
+ *        without expanding every surface form.
+ *
+ * A `.dic` file lists stems with the flags of the affixes they accept, and the
+ * `.aff` file defines those affixes (`PFX` and `SFX` rules with the text to
+ * strip, the text to add and a condition on the stem). A word is accepted when
+ * it is a stem, or when removing a suffix and/or a prefix allowed by its flags
+ * yields a stem.
+ *
+ * Stems are kept in a WordList with their flags in a parallel table, and
+ * affixes are sorted by the text they add, so a lookup is a handful of binary
+ * searches and doesn't allocate. Supported `.aff` directives are `FLAG`
+ * (single characters, `long` or `num`), `NEEDAFFIX`, `PFX` and `SFX`; files are
+ * read as UTF-8.
+ *
+ * Copies share the same tables.
+ */
+class AffixDictionary
+{
+public:
+    AffixDictionary() = default;
+
+    /**
+     * @brief Loads a `.aff` and `.dic` pair.
+     *
+     * @return The dictionary, empty if either file couldn't be read.
+     */
+    static AffixDictionary fromFiles(const QString& affixFileName, const QString& dictionaryFileName);
+
+    bool isEmpty() const { return !d || d->stems.isEmpty(); }
+
+    /**
+     * @brief Checks whether a word is a stem or an inflection of one.
+     *
+     * @param word A normalized word, see `WordTokenizer::normalize()`.
+     */
+    bool contains(QStringView word) const;
+
+private:
+    /**
+     * @brief One character of an affix condition: a character, a `[...]` or
+     *        `[^...]` class, or `.` for any character.
+     */
+    struct ConditionCharacter
+    {
+        QString characters; ///< Matching characters, empty for any character.
+        bool negated{false};
+
+        bool matches(QChar character) const
+        {
+            return characters.isEmpty() || characters.contains(character) != negated;
+        }
+    };
+
+    struct Affix
+    {
+        quint32 flag{0};
+        bool crossProduct{false}; ///< Can be combined with an affix of the other kind.
+        QString strip; ///< Removed from the stem before adding the affix.
+        QString append; ///< Added to the stem.
+        QVector<ConditionCharacter> condition; ///< Checked on the start (prefix) or end (suffix) of the stem.
+    };
+
+    struct Data
+    {
+        WordList stems;
+        QVector<quint32> flagOffsets; ///< Flags of stem `i` are [flagOffsets[i], flagOffsets[i + 1]).
+        QVector<quint32> flags; ///< Sorted flags of every stem.
+        quint32 needAffixFlag{0}; ///< Stems with this flag are only valid inflected.
+        QVector<Affix> prefixes; ///< Sorted by `append`.
+        QVector<Affix> suffixes; ///< Sorted by `append`.
+        QVector<qsizetype> prefixLengths; ///< Distinct lengths of the prefixes.
+        QVector<qsizetype> suffixLengths; ///< Distinct lengths of the suffixes.
+    };
+
+    enum class FlagType { Character, Long, Number };
+    using AffixIterator = QVector<Affix>::const_iterator;
+
+    /**
+     * @brief Returns the range of sorted `affixes` that add exactly `text`.
+     */
+    static std::pair<AffixIterator, AffixIterator> affixesAdding(const QVector<Affix>& affixes, QStringView text);
+
+    static QVector<quint32> parseFlags(QStringView text, FlagType type);
+    static QVector<ConditionCharacter> parseCondition(QStringView text);
+    static bool conditionMatches(const QVector<ConditionCharacter>& condition, QStringView stem, bool atEnd);
+
+    bool isStem(QStringView word, quint32 flag, quint32 secondFlag = 0) const;
+    bool hasFlag(qsizetype stem, quint32 flag) const;
+    bool containsWithSuffix(QStringView word, const Affix* prefix) const;
+
+    QSharedPointer<const Data> d;
+};
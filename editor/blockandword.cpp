@@ -0,0 +1,81 @@
+#include "blockandword.h"
+
+QVector<word> block::words() const
+{
+    QVector<word> words;
+    words.reserve(m_words.size());
+    for (qsizetype i = 0; i < m_words.size(); i++)
+        words.append(wordAt(i));
+    return words;
+}
+
+void block::setWords(const QVector<word>& words)
+{
+    qsizetype textSize = 0;
+    for (auto& a_word: words)
+        textSize += a_word.text.size() + 1;
+
+    m_text.resize(0);
+    m_words.resize(0);
+    reserve(words.size(), textSize);
+    for (auto& a_word: words)
+        appendWord(a_word);
+}
+
+void block::setText(QStringView text)
+{
+    m_text.resize(0);
+    m_words.resize(0);
+    m_words.reserve(text.count(u' ') + 1);
+
+    // An empty text still holds one empty word, as split(" ") gives
+    for (qsizetype start = 0;;) {
+        auto end = text.indexOf(u' ', start);
+        if (end == -1)
+            end = text.size();
+        appendWord(TranscriptTime::noTime, text.sliced(start, end - start), TagList(), true);
+        if (end == text.size())
+            break;
+        start = end + 1;
+    }
+}
+
+void block::appendWord(qint64 time, QStringView text, TagList tagList, bool isEdited)
+{
+    if (!m_words.isEmpty())
+        m_text.append(u' ');
+    m_text.append(text);
+
+    WordEntry entry;
+    entry.time = time;
+    entry.end = quint32(m_text.size());
+    entry.isEdited = isEdited;
+    entry.tagList = tagList;
+    m_words.append(entry);
+}
+
+void block::appendWords(const block& other)
+{
+    if (other.m_words.isEmpty())
+        return;
+
+    auto offset = m_words.isEmpty() ? 0 : m_text.size() + 1;
+    if (!m_words.isEmpty())
+        m_text.append(u' ');
+    m_text.append(other.m_text);
+
+    m_words.reserve(m_words.size() + other.m_words.size());
+    for (auto entry: other.m_words) {
+        entry.end = quint32(entry.end + offset);
+        m_words.append(entry);
+    }
+}
+
+void block::truncateWords(qsizetype count)
+{
+    if (count >= m_words.size())
+        return;
+
+    m_text.truncate(count ? m_words[count - 1].end : 0);
+    m_words.resize(count);
+}
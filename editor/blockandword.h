@@ -1,47 +1,193 @@
 #pragma once
 
+#include "taglist.h"
+
+#include <QString>
+#include <QStringView>
 #include <QVector>
 #include <QTime>
 
+/**
+ * @brief Conversions between the millisecond timestamps of the transcript and
+ *        QTime, for the player and the dialogs.
+ *
+ * Timestamps are milliseconds from the start of the media, so they don't wrap
+ * after 24 hours. QTime only holds a time of day, so the conversion wraps
+ * longer timestamps like the QTime timestamps used to.
+ */
+namespace TranscriptTime
+{
+constexpr qint64 noTime = -1; ///< Timestamp of a block or word that has none.
+constexpr qint64 msecsPerDay = 86400000;
+
+inline qint64 fromTime(const QTime& time) { return time.isValid() ? time.msecsSinceStartOfDay() : noTime; }
+inline QTime toTime(qint64 msecs) { return msecs < 0 ? QTime() : QTime::fromMSecsSinceStartOfDay(int(msecs % msecsPerDay)); }
+}
+
 struct word
 {
-    QTime timeStamp;
+    qint64 time; ///< End of the word in milliseconds, `TranscriptTime::noTime` if it has none.
     QString text;
-    QStringList tagList;
-    QString isEdited;
+    TagList tagList;
+    bool isEdited;
+
+    word(qint64 time, QString text, TagList tagList, bool isEdited = false)
+        : time(time), text(text), tagList(tagList), isEdited(isEdited) {}
 
-    word(QTime timeStamp, QString text, QStringList tagList, QString isEdited = "false")
-        : timeStamp(timeStamp), text(text), tagList(tagList), isEdited(isEdited) {}
+    word(QTime timeStamp, QString text, TagList tagList, bool isEdited = false)
+        : time(TranscriptTime::fromTime(timeStamp)), text(text), tagList(tagList), isEdited(isEdited) {}
 
-    word() : timeStamp(), text(), tagList(), isEdited("false") {}
+    word() : time(TranscriptTime::noTime), text(), tagList(), isEdited(false) {}
 
-    inline bool operator==(word w) const
+    bool hasTime() const { return time != TranscriptTime::noTime; }
+    QTime timeStamp() const { return TranscriptTime::toTime(time); }
+    void setTimeStamp(const QTime& timeStamp) { time = TranscriptTime::fromTime(timeStamp); }
+
+    inline bool operator==(const word& w) const
     {
-        if (w.timeStamp == timeStamp && w.text == text && w.isEdited == isEdited)
+        if (w.time == time && w.text == text && w.isEdited == isEdited)
             return true;
         return false;
     }
 };
 
+/**
+ * @struct block
+ * @brief A line of the transcript: its speaker, timestamp and tags, and its words.
+ *
+ * The words are stored contiguously. Their texts are joined by single spaces
+ * into the text of the line, which is the only copy of them, and their
+ * timestamps, tags and edited flags sit in one array of 16-byte entries, each
+ * holding where its word ends in the text. The text of the line can't drift
+ * from its words, and splitting it on single spaces, like `WordTokenizer`
+ * does, gives the words back at the same indices.
+ *
+ * The `word` values returned by `wordAt()` and `words()`, and taken by
+ * `setWords()`, keep the dialogs and the word editor working on separate words.
+ */
 struct block
 {
-    QTime timeStamp;
-    QString text;
+    qint64 time; ///< End of the block in milliseconds, `TranscriptTime::noTime` if it has none.
     QString speaker;
-    QStringList tagList;
-    QVector<word> words;
+    TagList tagList;
+
+    block() : time(TranscriptTime::noTime), speaker(), tagList() {};
+
+    block(qint64 time, QString speaker, TagList tagList, const QVector<word>& words)
+        : time(time), speaker(speaker), tagList(tagList) { setWords(words); };
+
+    block(QTime timeStamp, QString speaker, TagList tagList, const QVector<word>& words)
+        : time(TranscriptTime::fromTime(timeStamp)), speaker(speaker), tagList(tagList) { setWords(words); };
+
+    bool hasTime() const { return time != TranscriptTime::noTime; }
+    QTime timeStamp() const { return TranscriptTime::toTime(time); }
+    void setTimeStamp(const QTime& timeStamp) { time = TranscriptTime::fromTime(timeStamp); }
+
+    /**
+     * @brief Returns the text of the line, its words joined by single spaces.
+     */
+    const QString& text() const { return m_text; }
+
+    qsizetype wordCount() const { return m_words.size(); }
+
+    /**
+     * @brief Returns the text of word `i`, a view into `text()`.
+     */
+    QStringView wordText(qsizetype i) const
+    {
+        auto start = wordStart(i);
+        return QStringView(m_text).sliced(start, m_words[i].end - start);
+    }
+
+    /**
+     * @brief Returns the offset of word `i` in `text()`.
+     */
+    qsizetype wordStart(qsizetype i) const { return i ? m_words[i - 1].end + 1 : 0; }
 
-    block() : timeStamp(), text(), speaker(), tagList(), words() {};
+    qint64 wordTime(qsizetype i) const { return m_words[i].time; }
+    bool wordHasTime(qsizetype i) const { return m_words[i].time != TranscriptTime::noTime; }
+    TagList wordTags(qsizetype i) const { return m_words[i].tagList; }
+    bool isWordEdited(qsizetype i) const { return m_words[i].isEdited; }
 
-    block(QTime timeStamp, QString text, QString speaker, QStringList tagList, QVector<word> words)
-        : timeStamp(timeStamp), text(text), speaker(speaker), tagList(tagList), words(words) {};
+    void setWordTime(qsizetype i, qint64 time) { m_words[i].time = time; }
+    void setWordTags(qsizetype i, TagList tagList) { m_words[i].tagList = tagList; }
 
-    inline bool operator==(block b) const
+    /**
+     * @brief Returns word `i` as a separate value.
+     */
+    word wordAt(qsizetype i) const
     {
-        if(b.timeStamp==timeStamp && b.text==text && b.speaker==speaker && b.words==words)
+        return word(m_words[i].time, wordText(i).toString(), m_words[i].tagList, m_words[i].isEdited);
+    }
+
+    /**
+     * @brief Returns the words as separate values, for the dialogs and the word editor.
+     */
+    QVector<word> words() const;
+
+    /**
+     * @brief Replaces the words, joining their texts into the text of the line.
+     */
+    void setWords(const QVector<word>& words);
+
+    /**
+     * @brief Replaces the words with the ones of `text` split on single
+     *        spaces, edited and without timestamps or tags, as typed.
+     */
+    void setText(QStringView text);
+
+    /**
+     * @brief Appends a word to the line.
+     */
+    void appendWord(qint64 time, QStringView text, TagList tagList, bool isEdited);
+    void appendWord(const word& a_word) { appendWord(a_word.time, a_word.text, a_word.tagList, a_word.isEdited); }
+
+    /**
+     * @brief Appends the words of `other`, as merging two lines does.
+     */
+    void appendWords(const block& other);
+
+    /**
+     * @brief Keeps the first `count` words.
+     */
+    void truncateWords(qsizetype count);
+
+    /**
+     * @brief Reserves room for `count` words of `textSize` characters in all.
+     */
+    void reserve(qsizetype count, qsizetype textSize)
+    {
+        m_words.reserve(count);
+        m_text.reserve(textSize);
+    }
+
+    inline bool operator==(const block& b) const
+    {
+        if(b.time==time && b.m_text==m_text && b.speaker==speaker && b.m_words==m_words)
             return true;
         return false;
     }
+
+private:
+    /**
+     * @brief Timestamp, tags and edited flag of a word, with the end of its text.
+     */
+    struct WordEntry
+    {
+        qint64 time; ///< End of the word in milliseconds, `TranscriptTime::noTime` if it has none.
+        quint32 end : 31; ///< Offset in the text just past the word.
+        quint32 isEdited : 1;
+        TagList tagList;
+
+        bool operator==(const WordEntry& other) const
+        {
+            // Tags aren't compared, like for separate words
+            return time == other.time && end == other.end && isEdited == other.isEdited;
+        }
+    };
+
+    QString m_text; ///< Texts of the words, joined by single spaces.
+    QVector<WordEntry> m_words;
 };
 
 Q_DECLARE_METATYPE(block)
@@ -0,0 +1,98 @@
+#include "blockeditcommand.h"
+#include "editor.h"
+
+BlockEditCommand::BlockEditCommand(Editor* editor, int first, const QVector<block>& oldBlocks,
+                                   const QVector<block>& newBlocks, bool applied, const TypedEdit& typedEdit)
+    : m_editor(editor),
+    m_first(first),
+    m_oldBlocks(oldBlocks),
+    m_newBlocks(newBlocks),
+    m_applied(applied),
+    m_typed(applied && typedEdit.position >= 0 && oldBlocks.size() == 1 && newBlocks.size() == 1),
+    m_lastEdit(typedEdit)
+{
+    setText("Edit Transcript");
+}
+
+void BlockEditCommand::undo()
+{
+    m_editor->applyBlocks(m_first, m_newBlocks.size(), m_oldBlocks);
+    moveCursor(m_oldBlocks.size());
+}
+
+void BlockEditCommand::redo()
+{
+    if (!m_applied)
+        m_editor->applyBlocks(m_first, m_oldBlocks.size(), m_newBlocks);
+
+    // The first redo is the edit itself, which places the cursor on its own
+    if (m_redone)
+        moveCursor(m_newBlocks.size());
+
+    m_applied = false;
+    m_redone = true;
+}
+
+int BlockEditCommand::id() const
+{
+    return m_typed ? typedEditId : -1;
+}
+
+bool BlockEditCommand::mergeWith(const QUndoCommand* other)
+{
+    auto edit = static_cast<const BlockEditCommand*>(other);
+    if (!edit->m_typed || edit->m_first != m_first || !continues(edit->m_lastEdit))
+        return false;
+
+    m_newBlocks = edit->m_newBlocks;
+    m_lastEdit = edit->m_lastEdit;
+
+    // Typing a word and erasing it again leaves nothing to undo
+    if (m_newBlocks == m_oldBlocks)
+        setObsolete(true);
+    return true;
+}
+
+bool BlockEditCommand::continues(const TypedEdit& edit) const
+{
+    if (edit.time - m_lastEdit.time > mergeInterval)
+        return false;
+
+    // Typing goes on where the last edit ended, erasing where it started
+    bool adjacent = edit.position == m_lastEdit.position + m_lastEdit.charsAdded
+                    || edit.position + edit.charsRemoved == m_lastEdit.position;
+    if (!adjacent)
+        return false;
+
+    // A space typed after a word is the start of the next step
+    return !edit.addedSpace || m_lastEdit.addedSpace || !m_lastEdit.charsAdded;
+}
+
+void BlockEditCommand::moveCursor(int blockCount) const
+{
+    auto blockNumber = qMax(m_first + blockCount - 1, 0);
+    auto cursor = m_editor->blockCursor(qMin(blockNumber, m_editor->totalBlockCount() - 1));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    m_editor->setTextCursor(cursor);
+    m_editor->centerCursor();
+}
+
+BlockBatchCommand::BlockBatchCommand(Editor* editor, const QVector<int>& blockNumbers, const QVector<block>& oldBlocks,
+                                     const QVector<block>& newBlocks, const QString& text)
+    : m_editor(editor),
+    m_blockNumbers(blockNumbers),
+    m_oldBlocks(oldBlocks),
+    m_newBlocks(newBlocks)
+{
+    setText(text);
+}
+
+void BlockBatchCommand::undo()
+{
+    m_editor->applyBlocks(m_blockNumbers, m_oldBlocks);
+}
+
+void BlockBatchCommand::redo()
+{
+    m_editor->applyBlocks(m_blockNumbers, m_newBlocks);
+}
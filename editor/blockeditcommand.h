@@ -0,0 +1,114 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QUndoCommand>
+#include <QVector>
+
+class Editor;
+
+/**
+ * @struct TypedEdit
+ * @brief Document change a typed step was recorded from, to tell whether the
+ *        next one continues it.
+ */
+struct TypedEdit
+{
+    int position{-1}; ///< Position of the change in its line, -1 if it wasn't typed.
+    int charsRemoved{0};
+    int charsAdded{0};
+    bool addedSpace{false}; ///< Only spaces were added.
+    qint64 time{0}; ///< When it was made, in milliseconds since the epoch.
+};
+
+/**
+ * @class BlockEditCommand
+ * @brief Undo step replacing a range of the blocks of a transcript.
+ *
+ * Only the replaced blocks and the blocks replacing them are stored. Their
+ * texts and word vectors are implicitly shared with `Editor::m_blocks` and
+ * with the neighbouring steps, so a step costs the blocks it changed rather
+ * than a copy of the transcript, and a deep history stays affordable.
+ *
+ * Consecutive edits typed into the same line are merged into one step, like
+ * the document's own history does: a step ends with a space typed after a
+ * word, when the cursor moved away from the last edit, or after a pause in
+ * typing.
+ */
+class BlockEditCommand : public QUndoCommand
+{
+public:
+    /**
+     * @param editor Editor whose blocks are replaced.
+     * @param first Number of the first replaced block.
+     * @param oldBlocks The replaced blocks.
+     * @param newBlocks The blocks replacing them.
+     * @param applied Whether the edit was already made, e.g. typed in the
+     *        document, so the first `redo()` has nothing to do.
+     * @param typedEdit The document change of a typed edit, which may be
+     *        merged with the next one.
+     */
+    BlockEditCommand(Editor* editor, int first, const QVector<block>& oldBlocks,
+                     const QVector<block>& newBlocks, bool applied = false,
+                     const TypedEdit& typedEdit = TypedEdit());
+
+    void undo() override;
+    void redo() override;
+    int id() const override;
+    bool mergeWith(const QUndoCommand* other) override;
+
+private:
+    static constexpr int typedEditId = 1;
+    static constexpr qint64 mergeInterval = 2000; ///< Pause in milliseconds after which typing starts a new step.
+
+    /**
+     * @brief Checks whether `edit` continues the last edit of the step, at
+     *        the position it left off and without starting a word.
+     */
+    bool continues(const TypedEdit& edit) const;
+
+    /**
+     * @brief Moves the text cursor to the end of the last block of the step.
+     */
+    void moveCursor(int blockCount) const;
+
+    Editor* m_editor;
+    int m_first;
+    QVector<block> m_oldBlocks;
+    QVector<block> m_newBlocks;
+    bool m_applied;
+    bool m_typed;
+    TypedEdit m_lastEdit; ///< Last typed edit merged into the step.
+    bool m_redone{false};
+};
+
+/**
+ * @class BlockBatchCommand
+ * @brief Undo step replacing scattered blocks of a transcript one for one.
+ *
+ * Used by the operations touching many lines without adding or removing
+ * any, such as renaming a speaker, so the whole change is applied in one
+ * pass by `Editor::applyBlocks()` instead of one step per line.
+ */
+class BlockBatchCommand : public QUndoCommand
+{
+public:
+    /**
+     * @param editor Editor whose blocks are replaced.
+     * @param blockNumbers Numbers of the replaced blocks, in increasing order.
+     * @param oldBlocks The replaced blocks.
+     * @param newBlocks The blocks replacing them.
+     * @param text Name of the step.
+     */
+    BlockBatchCommand(Editor* editor, const QVector<int>& blockNumbers, const QVector<block>& oldBlocks,
+                      const QVector<block>& newBlocks, const QString& text);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    Editor* m_editor;
+    QVector<int> m_blockNumbers;
+    QVector<block> m_oldBlocks;
+    QVector<block> m_newBlocks;
+};
@@ -0,0 +1,94 @@
+#include "blockvalidator.h"
+#include "wordtokenizer.h"
+
+#include <algorithm>
+
+bool BlockValidator::isWordValid(QStringView wordText, const ValidationContext& context)
+{
+    if (context.dictionary.contains(wordText) || context.affixes.contains(wordText)) return true;
+
+    if (std::binary_search(context.correctedWords.cbegin(), context.correctedWords.cend(), wordText,
+                           [](QStringView a, QStringView b) { return a < b; }))
+        return true;
+
+    if (context.language != "english") {
+        return context.englishDictionary.contains(wordText) || context.englishAffixes.contains(wordText);
+    }
+
+    return false;
+}
+
+BlockValidation BlockValidator::validate(const block& a_block, const ValidationContext& context)
+{
+    BlockValidation validation;
+
+    if (!a_block.hasTime()) {
+        validation.invalidBlock = true;
+        return validation;
+    }
+    if (!a_block.tagList.isEmpty()) {
+        validation.taggedBlock = true;
+        return validation;
+    }
+
+    validation.invalidWords.resize(a_block.wordCount());
+    validation.taggedWords.resize(a_block.wordCount());
+    validation.editedWords.resize(a_block.wordCount());
+
+    QString keyBuffer;
+    for (int j = 0; j < a_block.wordCount(); j++) {
+        if (a_block.isWordEdited(j))
+            validation.editedWords.setBit(j);
+
+        auto wordText = WordTokenizer::lowercase(WordTokenizer::strip(a_block.wordText(j), context.punctuation), keyBuffer);
+
+        // the string is a valid time in the format "HH:MM:SS.f"
+        if (WordTokenizer::containsTime(wordText))
+            continue;
+
+        if (!isWordValid(wordText, context))
+            validation.invalidWords.setBit(j);
+        if (!a_block.wordTags(j).empty())
+            validation.taggedWords.setBit(j);
+    }
+
+    return validation;
+}
+
+void BlockValidator::validateBlocks(QPromise<ValidationChunk>& promise,
+                                    quint64 generation,
+                                    QVector<block> blocks,
+                                    ValidationContext context,
+                                    int firstVisible,
+                                    int lastVisible)
+{
+    auto validateRange = [&](int first, int last) {
+        for (int start = first; start <= last; start += chunkSize) {
+            if (promise.isCanceled())
+                return false;
+
+            ValidationChunk chunk;
+            chunk.generation = generation;
+            chunk.firstBlock = start;
+
+            int end = qMin(start + chunkSize - 1, last);
+            chunk.validations.reserve(end - start + 1);
+            for (int i = start; i <= end; i++)
+                chunk.validations.append(validate(blocks[i], context));
+
+            promise.addResult(std::move(chunk));
+        }
+        return true;
+    };
+
+    if (blocks.isEmpty())
+        return;
+
+    int lastBlock = blocks.size() - 1;
+    firstVisible = qBound(0, firstVisible, lastBlock);
+    lastVisible = qBound(firstVisible, lastVisible, lastBlock);
+
+    validateRange(firstVisible, lastVisible)
+        && validateRange(0, firstVisible - 1)
+        && validateRange(lastVisible + 1, lastBlock);
+}
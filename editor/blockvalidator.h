@@ -0,0 +1,118 @@
+#pragma once
+
+#include "blockandword.h"
+#include "wordlist.h"
+#include "affixdictionary.h"
+
+#include <QBitArray>
+#include <QPromise>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @struct BlockValidation
+ * @brief Cached spell-check and tag state of a single transcript block.
+ *
+ * One entry is kept per block in `Editor::m_blockValidation` so that an edit
+ * only re-validates the blocks it touched. Word flags are bitsets indexed by
+ * the word number within the block.
+ */
+struct BlockValidation
+{
+    bool invalidBlock{false}; ///< Block has no valid timestamp.
+    bool taggedBlock{false}; ///< Block carries block level tags.
+    QBitArray invalidWords; ///< Words not found in the dictionaries.
+    QBitArray taggedWords; ///< Words carrying tags.
+    QBitArray editedWords; ///< Words edited by the annotator.
+
+    /**
+     * @brief Checks whether the block needs any highlighting at all.
+     */
+    bool isClear() const
+    {
+        return !invalidBlock && !taggedBlock
+               && !invalidWords.count(true) && !taggedWords.count(true) && !editedWords.count(true);
+    }
+
+    bool operator==(const BlockValidation& other) const
+    {
+        return invalidBlock == other.invalidBlock && taggedBlock == other.taggedBlock
+               && invalidWords == other.invalidWords && taggedWords == other.taggedWords
+               && editedWords == other.editedWords;
+    }
+    bool operator!=(const BlockValidation& other) const { return !(*this == other); }
+};
+
+/**
+ * @struct ValidationContext
+ * @brief Immutable snapshot of everything the spell-check needs, so blocks
+ *        can be validated away from the GUI thread.
+ */
+struct ValidationContext
+{
+    WordList dictionary; ///< Dictionary of the transcript language.
+    QStringList correctedWords; ///< Words marked correct on top of `dictionary`, sorted.
+    WordList englishDictionary; ///< English dictionary, accepted in other languages.
+    AffixDictionary affixes; ///< Stems and affixes of the transcript language, if installed.
+    AffixDictionary englishAffixes; ///< Stems and affixes of English, if installed.
+    QString language; ///< Transcript language.
+    QString punctuation; ///< Punctuation stripped from the end of words.
+};
+
+/**
+ * @struct ValidationChunk
+ * @brief Results of a run of consecutive blocks, reported by the worker.
+ */
+struct ValidationChunk
+{
+    quint64 generation{0}; ///< Validation run the results belong to.
+    int firstBlock{0}; ///< Number of the first block in `validations`.
+    QVector<BlockValidation> validations; ///< Results of the blocks, in order.
+};
+
+/**
+ * @class BlockValidator
+ * @brief Spell-check and tag checks of transcript blocks.
+ *
+ * Everything here only reads its arguments, so it is safe to run on a worker
+ * thread against a snapshot of the blocks.
+ */
+class BlockValidator
+{
+public:
+    static constexpr int chunkSize = 256; ///< Blocks reported per ValidationChunk.
+
+    /**
+     * @brief Checks a normalized word against the dictionaries.
+     */
+    static bool isWordValid(QStringView wordText, const ValidationContext& context);
+
+    /**
+     * @brief Runs the dictionary and tag checks for a single block.
+     *
+     * @param a_block The block to validate.
+     * @param context Dictionaries to check against.
+     * @return The validation state of the block.
+     */
+    static BlockValidation validate(const block& a_block, const ValidationContext& context);
+
+    /**
+     * @brief Validates a snapshot of the transcript, reporting results in chunks.
+     *
+     * The blocks in [firstVisible, lastVisible] are validated first, then the
+     * rest in document order. Stops early when the promise is canceled.
+     *
+     * @param promise Receives one ValidationChunk per run of blocks.
+     * @param generation Tag copied into every chunk.
+     * @param blocks Snapshot of the transcript blocks.
+     * @param context Dictionaries to check against.
+     * @param firstVisible First block shown in the viewport.
+     * @param lastVisible Last block shown in the viewport.
+     */
+    static void validateBlocks(QPromise<ValidationChunk>& promise,
+                               quint64 generation,
+                               QVector<block> blocks,
+                               ValidationContext context,
+                               int firstVisible,
+                               int lastVisible);
+};
@@ -0,0 +1,54 @@
+#include "completionmodel.h"
+
+#include <QSet>
+#include <algorithm>
+
+void CompletionModel::setDictionary(const WordList& words)
+{
+    m_dictionary = words;
+}
+
+void CompletionModel::setCorrectedWords(const QStringList& words)
+{
+    m_correctedWords = words;
+}
+
+void CompletionModel::setPrefix(QStringView prefix)
+{
+    beginResetModel();
+
+    m_completions = m_transcriptWords->completions(prefix, maxTranscriptCompletions);
+    QSet<QString> shownCompletions(m_completions.cbegin(), m_completions.cend());
+
+    // Words marked correct aren't in the table yet, they are listed before it
+    auto corrected = std::lower_bound(m_correctedWords.cbegin(), m_correctedWords.cend(), prefix,
+                                      [](QStringView a, QStringView b) { return a < b; });
+    for (; corrected != m_correctedWords.cend() && m_completions.size() < maxCompletions; ++corrected) {
+        if (!corrected->startsWith(prefix))
+            break;
+        if (!shownCompletions.contains(*corrected)) {
+            m_completions << *corrected;
+            shownCompletions.insert(*corrected);
+        }
+    }
+
+    // Dictionary words sharing the prefix are contiguous in the sorted table
+    for (auto i = m_dictionary.lowerBound(prefix);
+         i < m_dictionary.size() && m_completions.size() < maxCompletions; i++) {
+        auto word = m_dictionary.at(i);
+        if (!word.startsWith(prefix))
+            break;
+        if (!shownCompletions.contains(word.toString()))
+            m_completions << word.toString();
+    }
+
+    endResetModel();
+}
+
+QVariant CompletionModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_completions.size()
+        || (role != Qt::DisplayRole && role != Qt::EditRole))
+        return QVariant();
+    return m_completions[index.row()];
+}
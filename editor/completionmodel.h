@@ -0,0 +1,56 @@
+#pragma once
+
+#include "completiontrie.h"
+#include "wordlist.h"
+
+#include <QAbstractListModel>
+
+/**
+ * @class CompletionModel
+ * @brief Completions of the current word prefix for the text completer.
+ *
+ * Words already used in the transcript come first, ranked by the number of
+ * times they occur (see CompletionTrie), followed by the words marked correct
+ * and the dictionary words starting with the prefix, in alphabetical order. Only the top completions
+ * are held, so the completer is used in `QCompleter::UnfilteredPopupCompletion`
+ * mode and the model is updated with `setPrefix()` on every keystroke.
+ */
+class CompletionModel : public QAbstractListModel
+{
+public:
+    static constexpr int maxTranscriptCompletions = 10; ///< Transcript words shown first.
+    static constexpr int maxCompletions = 50; ///< Rows of the model.
+
+    explicit CompletionModel(const CompletionTrie* transcriptWords, QObject* parent = nullptr)
+        : QAbstractListModel(parent), m_transcriptWords(transcriptWords) {}
+
+    /**
+     * @brief Sets the dictionary completing the transcript words.
+     */
+    void setDictionary(const WordList& words);
+
+    /**
+     * @brief Sets the sorted words marked correct on top of the dictionary.
+     */
+    void setCorrectedWords(const QStringList& words);
+
+    /**
+     * @brief Fills the model with the completions of `prefix`.
+     *
+     * @param prefix A normalized prefix.
+     */
+    void setPrefix(QStringView prefix);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_completions.size();
+    }
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    const CompletionTrie* m_transcriptWords;
+    WordList m_dictionary;
+    QStringList m_correctedWords;
+    QStringList m_completions;
+};
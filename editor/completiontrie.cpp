@@ -0,0 +1,123 @@
+#include "completiontrie.h"
+
+#include <queue>
+
+void CompletionTrie::clear()
+{
+    m_nodes.clear();
+    m_nodes.append(Node());
+}
+
+void CompletionTrie::add(QStringView word, int count)
+{
+    if (word.isEmpty() || !count)
+        return;
+
+    QVector<int> path;
+    path.reserve(word.size() + 1);
+    path.append(0);
+
+    int node = 0;
+    for (auto character: word) {
+        int next = child(node, character.unicode());
+        if (next == -1) {
+            // Nothing to remove from a word that isn't there
+            if (count < 0)
+                return;
+
+            Node newNode;
+            newNode.character = character.unicode();
+            newNode.nextSibling = m_nodes[node].firstChild;
+            next = m_nodes.size();
+            m_nodes.append(newNode);
+            m_nodes[node].firstChild = next;
+        }
+        node = next;
+        path.append(node);
+    }
+
+    auto& frequency = m_nodes[node].frequency;
+    frequency = qMax(0, frequency + count);
+
+    // Bounds are only raised, a removal leaves them as an overestimate
+    for (auto i: std::as_const(path))
+        m_nodes[i].maxFrequency = qMax(m_nodes[i].maxFrequency, frequency);
+}
+
+int CompletionTrie::frequency(QStringView word) const
+{
+    int node = find(word);
+    return node == -1 ? 0 : m_nodes[node].frequency;
+}
+
+QStringList CompletionTrie::completions(QStringView prefix, int maxCount) const
+{
+    QStringList result;
+
+    int start = find(prefix);
+    if (start == -1 || !m_nodes[start].maxFrequency || maxCount <= 0)
+        return result;
+
+    struct Candidate
+    {
+        int bound; ///< Frequency of the word, or the bound of the subtree.
+        bool isWord;
+        int node;
+        QString text;
+
+        bool operator<(const Candidate& other) const
+        {
+            // Reversed for the max-heap, ties go to complete words then alphabetical order
+            if (bound != other.bound)
+                return bound < other.bound;
+            if (isWord != other.isWord)
+                return !isWord;
+            return text > other.text;
+        }
+    };
+
+    // Every bound is at least the frequency of the words below it, so words
+    // come out of the queue from the most to the least frequent
+    std::priority_queue<Candidate> queue;
+    queue.push({m_nodes[start].maxFrequency, false, start, prefix.toString()});
+
+    while (!queue.empty() && result.size() < maxCount) {
+        auto candidate = queue.top();
+        queue.pop();
+
+        if (candidate.isWord) {
+            result << candidate.text;
+            continue;
+        }
+
+        const auto& node = m_nodes[candidate.node];
+        if (node.frequency)
+            queue.push({node.frequency, true, candidate.node, candidate.text});
+        for (int i = node.firstChild; i != -1; i = m_nodes[i].nextSibling) {
+            if (m_nodes[i].maxFrequency)
+                queue.push({m_nodes[i].maxFrequency, false, i, candidate.text + QChar(m_nodes[i].character)});
+        }
+    }
+
+    return result;
+}
+
+int CompletionTrie::child(int node, char16_t character) const
+{
+    for (int i = m_nodes[node].firstChild; i != -1; i = m_nodes[i].nextSibling) {
+        if (m_nodes[i].character == character)
+            return i;
+    }
+    return -1;
+}
+
+int CompletionTrie::find(QStringView prefix) const
+{
+    int node = 0;
+    for (auto character: prefix) {
+        node = child(node, character.unicode());
+        if (node == -1)
+            return -1;
+    }
+    return node;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @class CompletionTrie
+ * @brief Prefix tree of the words of the open transcript with their number of
+ *        occurrences, queried for the most frequent completions of a prefix.
+ *
+ * Nodes are stored in a single vector and linked as first child / next sibling,
+ * so inserting a word allocates at most one node per new character. Each node
+ * also keeps an upper bound of the frequencies below it, which lets
+ * `completions()` visit the subtree best-first and stop after `maxCount` words
+ * instead of walking every word starting with the prefix.
+ */
+class CompletionTrie
+{
+public:
+    CompletionTrie() { clear(); }
+
+    /**
+     * @brief Removes all the words.
+     */
+    void clear();
+
+    /**
+     * @brief Adds `count` occurrences of a word, negative counts remove them.
+     *
+     * @param word A normalized word, see `WordTokenizer::normalize()`.
+     */
+    void add(QStringView word, int count = 1);
+
+    /**
+     * @brief Returns the number of occurrences of a word.
+     */
+    int frequency(QStringView word) const;
+
+    /**
+     * @brief Returns the most frequent words starting with `prefix`, most
+     *        frequent first.
+     *
+     * @param prefix A normalized prefix.
+     * @param maxCount Maximum number of words.
+     */
+    QStringList completions(QStringView prefix, int maxCount) const;
+
+private:
+    struct Node
+    {
+        char16_t character{0};
+        int firstChild{-1};
+        int nextSibling{-1};
+        int frequency{0}; ///< Occurrences of the word ending at this node.
+        int maxFrequency{0}; ///< Upper bound of the frequencies in the subtree.
+    };
+
+    int child(int node, char16_t character) const;
+    int find(QStringView prefix) const;
+
+    QVector<Node> m_nodes; ///< The root is node 0.
+};
@@ -0,0 +1,192 @@
+#include "dictionaryservice.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <QtConcurrent/qtconcurrentrun.h>
+
+DictionaryService& DictionaryService::getInstance()
+{
+    static DictionaryService instance;
+    return instance;
+}
+
+void DictionaryService::load(const QString& language)
+{
+    touch(language);
+
+    auto cached = m_cache.constFind(language);
+    if (cached != m_cache.cend()) {
+        emit dictionaryReady(language, *cached);
+        return;
+    }
+    if (m_pending.contains(language))
+        return;
+
+    auto future = QtConcurrent::run(&DictionaryService::loadLanguage, language);
+    m_pending.insert(language, future);
+    future.then(this, [this, language](WordList words) {
+        // Already handed out by dictionary() if it waited for it
+        if (!m_pending.contains(language))
+            return;
+        m_pending.remove(language);
+        insert(language, words);
+        emit dictionaryReady(language, words);
+    });
+}
+
+void DictionaryService::acquire(const QString& language)
+{
+    m_holders[language]++;
+    touch(language);
+}
+
+void DictionaryService::release(const QString& language)
+{
+    auto holders = m_holders.find(language);
+    if (holders == m_holders.end())
+        return;
+    if (--*holders == 0)
+        m_holders.erase(holders);
+    touch(language);
+}
+
+WordList DictionaryService::dictionary(const QString& language)
+{
+    touch(language);
+
+    auto cached = m_cache.constFind(language);
+    if (cached != m_cache.cend())
+        return *cached;
+
+    auto words = m_pending.contains(language) ? m_pending.take(language).result()
+                                              : loadLanguage(language);
+    insert(language, words);
+    emit dictionaryReady(language, words);
+    return words;
+}
+
+void DictionaryService::update(const QString& language, const WordList& words)
+{
+    touch(language);
+    m_pending.remove(language);
+    insert(language, words);
+    emit dictionaryReady(language, words);
+}
+
+bool DictionaryService::addCorrectedWord(const QString& language, const QString& word)
+{
+    auto& words = m_correctedWords[language];
+    auto position = std::lower_bound(words.begin(), words.end(), word);
+    if (position != words.end() && *position == word)
+        return false;
+
+    words.insert(position, word);
+    emit correctedWordAdded(language, word);
+    return true;
+}
+
+WordList DictionaryService::loadLanguage(const QString& language)
+{
+    WordList words;
+
+    // Custom merges are kept as text and compiled next to it, the compiled
+    // table is used as long as it is newer than the text
+    auto combinedFileName = "Dictonaries/"+language+"/"+language+"combined";
+    QFileInfo combinedText(combinedFileName + ".txt");
+    QFileInfo combinedCompiled(combinedFileName + ".vwl");
+    if (combinedCompiled.exists()
+        && (!combinedText.exists() || combinedCompiled.lastModified() >= combinedText.lastModified())) {
+        words = WordList::fromFile(combinedCompiled.filePath());
+    }
+    if (words.isEmpty() && combinedText.exists()) {
+        words = WordList::fromFile(combinedText.filePath());
+        if (!words.save(combinedCompiled.filePath()))
+            qDebug() << "From DictionaryService - 1";
+    }
+    if (words.isEmpty())
+        words = WordList::fromResource(language);
+
+    QFile correctedWords(QString("corrected_words_%1.txt").arg(language));
+    if (correctedWords.open(QFile::ReadOnly)) {
+        QStringList correctedWordsList;
+        while (!correctedWords.atEnd()) {
+            auto line = correctedWords.readLine().trimmed();
+            if (!line.isEmpty())
+                correctedWordsList << QString::fromUtf8(line);
+        }
+        if (!correctedWordsList.isEmpty())
+            words = words.merged(correctedWordsList);
+    }
+
+    return words;
+}
+
+void DictionaryService::insert(const QString& language, const WordList& words)
+{
+    // A language evicted while it loaded comes back as the most recent one
+    if (!m_recentLanguages.contains(language))
+        m_recentLanguages.prepend(language);
+
+    m_cache.insert(language, words);
+    m_correctors.remove(language);
+    buildCorrector(language, words);
+
+    // Loaded once per language, custom and corrected words don't change it.
+    // Most languages have no pair installed, those don't need a worker.
+    if (!m_affixes.contains(language)) {
+        m_affixes.insert(language, AffixDictionary());
+        auto affixFileName = "Dictonaries/"+language+"/"+language;
+        if (!QFileInfo::exists(affixFileName + ".aff") || !QFileInfo::exists(affixFileName + ".dic"))
+            return;
+        QtConcurrent::run(&DictionaryService::loadAffixes, language).then(this, [this, language](AffixDictionary affixes) {
+            if (!m_affixes.contains(language) || affixes.isEmpty())
+                return;
+            m_affixes.insert(language, affixes);
+            emit affixesReady(language);
+        });
+    }
+}
+
+AffixDictionary DictionaryService::loadAffixes(const QString& language)
+{
+    auto fileName = "Dictonaries/"+language+"/"+language;
+    return AffixDictionary::fromFiles(fileName + ".aff", fileName + ".dic");
+}
+
+void DictionaryService::buildCorrector(const QString& language, const WordList& words)
+{
+    QtConcurrent::run([words]() {
+        return QSharedPointer<const SpellingCorrector>(new SpellingCorrector(words));
+    }).then(this, [this, language, words](QSharedPointer<const SpellingCorrector> corrector) {
+        // Dropped if the dictionary was replaced or evicted meanwhile
+        auto cached = m_cache.constFind(language);
+        if (cached != m_cache.cend() && cached->isSharedWith(words))
+            m_correctors.insert(language, corrector);
+    });
+}
+
+void DictionaryService::touch(const QString& language)
+{
+    m_recentLanguages.removeAll(language);
+    m_recentLanguages.prepend(language);
+    evict();
+}
+
+void DictionaryService::evict()
+{
+    // Languages an editor holds don't count, they are never evicted
+    int unused = 0;
+    for (auto i = 0; i < m_recentLanguages.size();) {
+        auto& language = m_recentLanguages.at(i);
+        if (m_holders.contains(language) || ++unused <= maxCachedLanguages) {
+            i++;
+            continue;
+        }
+        m_cache.remove(language);
+        m_correctors.remove(language);
+        m_affixes.remove(language);
+        m_recentLanguages.removeAt(i);
+    }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "wordlist.h"
+#include "affixdictionary.h"
+#include "spellingcorrector.h"
+
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+
+/**
+ * @class DictionaryService
+ * @brief Loads the dictionary of each language once and shares it between
+ *        all the editors.
+ *
+ * Dictionaries are loaded on a background thread and handed out as WordList
+ * copies, which share the same table. Editors hold the languages they use with
+ * `acquire()`, those stay cached with their corrector and affixes. Besides
+ * them, the most recently used languages no editor holds stay cached, so
+ * switching back and forth between them is instant. A
+ * SpellingCorrector is built in the background for every loaded dictionary,
+ * and the AffixDictionary of the language is loaded next to it when one is
+ * installed.
+ *
+ * The service lives in the GUI thread and must only be used from it.
+ */
+class DictionaryService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DictionaryService& getInstance();
+
+    /**
+     * @brief Starts loading the dictionary of a language on a worker thread.
+     *
+     * `dictionaryReady()` is emitted once it is available, right away if it
+     * was cached.
+     *
+     * @param language Transcript language, e.g. "english".
+     */
+    void load(const QString& language);
+
+    /**
+     * @brief Marks a language as used by an editor, it isn't evicted until
+     *        every editor holding it released it.
+     */
+    void acquire(const QString& language);
+
+    /**
+     * @brief Releases a language held with `acquire()`, it then stays cached
+     *        as the most recently used one.
+     */
+    void release(const QString& language);
+
+    /**
+     * @brief Returns the dictionary of a language, waiting for it to load if needed.
+     */
+    WordList dictionary(const QString& language);
+
+    /**
+     * @brief Replaces the shared dictionary of a language, after custom or
+     *        corrected words were merged into it.
+     */
+    void update(const QString& language, const WordList& words);
+
+    /**
+     * @brief Returns the words marked correct in a language during this
+     *        session, sorted.
+     */
+    QStringList correctedWords(const QString& language) const
+    {
+        return m_correctedWords.value(language);
+    }
+
+    /**
+     * @brief Accepts a word in a language without rebuilding its dictionary.
+     *
+     * The word is inserted into a small sorted overlay checked next to the
+     * shared table, and `correctedWordAdded()` is emitted.
+     *
+     * @return False if the word was already in the overlay.
+     */
+    bool addCorrectedWord(const QString& language, const QString& word);
+
+    /**
+     * @brief Returns the spelling corrector of a language, or null while it is
+     *        still being built.
+     */
+    QSharedPointer<const SpellingCorrector> corrector(const QString& language) const
+    {
+        return m_correctors.value(language);
+    }
+
+    /**
+     * @brief Returns the affix dictionary of a language, empty while it is
+     *        loading or if the language has none.
+     */
+    AffixDictionary affixes(const QString& language) const
+    {
+        return m_affixes.value(language);
+    }
+
+signals:
+    /**
+     * @brief Emitted when the dictionary of a language was loaded or replaced.
+     */
+    void dictionaryReady(const QString& language, const WordList& words);
+
+    /**
+     * @brief Emitted when the affix dictionary of a language was loaded.
+     */
+    void affixesReady(const QString& language);
+
+    /**
+     * @brief Emitted when a word was added to the corrected words of a language.
+     */
+    void correctedWordAdded(const QString& language, const QString& word);
+
+private:
+    DictionaryService() = default;
+    DictionaryService(const DictionaryService&) = delete;
+    DictionaryService& operator=(const DictionaryService&) = delete;
+
+    /**
+     * @brief Reads the dictionary of a language, run on a worker thread.
+     *
+     * The compiled custom merge in `Dictonaries/<language>/` is preferred, then
+     * the text merge (which is compiled and saved for the next run), then the
+     * bundled wordlist. The words in `corrected_words_<language>.txt` are merged in.
+     */
+    static WordList loadLanguage(const QString& language);
+
+    /**
+     * @brief Reads `<language>.aff` and `<language>.dic` from `Dictonaries/<language>/`,
+     *        run on a worker thread.
+     *
+     * Only installed pairs are read, none are bundled.
+     */
+    static AffixDictionary loadAffixes(const QString& language);
+
+    void insert(const QString& language, const WordList& words);
+    void buildCorrector(const QString& language, const WordList& words);
+    void touch(const QString& language);
+
+    /**
+     * @brief Evicts the least recently used languages no editor holds, past
+     *        `maxCachedLanguages` of them.
+     */
+    void evict();
+
+    static constexpr int maxCachedLanguages = 3; ///< Cached languages besides the held ones.
+
+    QHash<QString, WordList> m_cache; ///< Loaded dictionaries by language.
+    QHash<QString, QFuture<WordList>> m_pending; ///< Dictionaries being loaded.
+    QHash<QString, QSharedPointer<const SpellingCorrector>> m_correctors; ///< Correctors of the cached dictionaries.
+    QHash<QString, AffixDictionary> m_affixes; ///< Affix dictionaries of the cached languages, empty for none.
+    QHash<QString, QStringList> m_correctedWords; ///< Sorted words marked correct this session, kept across evictions.
+    QStringList m_recentLanguages; ///< Cached languages, most recently used first.
+    QHash<QString, int> m_holders; ///< Editors holding each language, see `acquire()`.
+};
@@ -1,4 +1,9 @@
 #include "editor.h"
+#include "wordtokenizer.h"
+#include "dictionaryservice.h"
+#include "transcriptreader.h"
+#include "timecodec.h"
+#include "transcriptwriter.h"
 #include <iostream>
 #include <qclipboard.h>
 #include <QJsonDocument>
@@ -16,34 +21,72 @@
 #include <QMessageBox>
 #include <QMenu>
 #include <algorithm>
+#include <utility>
 #include <QEventLoop>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QDateTime>
 #include <QUndoStack>
 #include <QPrinter>
 #include <qthreadpool.h>
+#include <QtConcurrent/qtconcurrentrun.h>
 // #include "config/settingsmanager.h"
 
 Editor::Editor(QWidget *parent)
     : TextEditor(parent),
     m_speakerCompleter(makeCompleter()), m_textCompleter(makeCompleter()), m_transliterationCompleter(makeCompleter()),
-    m_dictionary(listFromFile(":/wordlists/english.txt")), m_transcriptLang("english"),
-    timeStampExp(QRegularExpression(R"(\{(\d?\d:)?[0-5]?\d:[0-5]?\d(\.\d\d?\d?)?\})")),
-    speakerExp(QRegularExpression(R"(\{.*\}:)")),
+    m_transcriptLang("english"),
     m_saveTimer(new QTimer(this))
 {
     // taskSemaphore.release();
     connect(this->document(), &QTextDocument::contentsChange, this, &Editor::contentChanged);
+
+    // Created after the contentsChange connection so the validation state is
+    // updated before the highlighter reformats the edited blocks.
+    m_highlighter = new Highlighter(document());
+    connect(&m_validationWatcher, &QFutureWatcher<ValidationChunk>::resultsReadyAt, this, &Editor::applyValidationResults);
+    connect(&m_loadWatcher, &QFutureWatcher<TranscriptChunk>::resultsReadyAt, this, &Editor::applyLoadedChunks);
+
+    // Connected first, so the slots below see the cursor where it was moved
+    connect(this, &Editor::cursorPositionChanged, this, [this]() {
+        if (!settingContent)
+            m_parkedBlock = -1;
+    });
     connect(this, &Editor::cursorPositionChanged, this, &Editor::updateWordEditor);
+    connect(this, &Editor::timeStampDoubleClicked, this, &Editor::editTimeStamp);
+    connect(this, &Editor::cursorPositionChanged, this, &Editor::showWordStatus);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &Editor::highlightOccurrences);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &Editor::updateHighlightWindow);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged, this, &Editor::updateHighlightWindow);
     connect(this, &Editor::cursorPositionChanged, this,
             [&]()
             {
-                if (!m_blocks.isEmpty() && textCursor().blockNumber() < m_blocks.size())
-                    emit refreshTagList(m_blocks[textCursor().blockNumber()].tagList);
+                if (!m_blocks.isEmpty() && cursorBlockNumber() < m_blocks.size())
+                    emit refreshTagList(m_blocks[cursorBlockNumber()].tagList);
             });
 
-    m_textCompleter->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
+    // The document only holds a window of the transcript, the block scroll
+    // bar covers all of it
+    setBlockScrollBar(new QScrollBar(Qt::Vertical, this));
+    connect(blockScrollBar(), &QScrollBar::valueChanged, this, &Editor::scrollToBlock);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &Editor::updateBlockScrollBar);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged, this, &Editor::updateBlockScrollBar);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &Editor::scheduleWindowUpdate);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged, this, &Editor::scheduleWindowUpdate);
+
+    // The model only holds the completions of the current prefix, ranked by use
+    m_completionModel = new CompletionModel(&m_transcriptWords, m_textCompleter);
+    m_textCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_textCompleter->setModel(m_completionModel);
     m_transliterationCompleter->setModel(new QStringListModel);
+    m_speakerCompleter->setModel(new QStringListModel(m_speakerCompleter));
 
+    connect(&DictionaryService::getInstance(), &DictionaryService::dictionaryReady, this, &Editor::dictionaryReady);
+    connect(&DictionaryService::getInstance(), &DictionaryService::affixesReady, this, [this](const QString& language) {
+        if (language == m_transcriptLang || language == "english")
+            startValidation();
+    });
+    connect(&DictionaryService::getInstance(), &DictionaryService::correctedWordAdded, this, &Editor::correctedWordAdded);
     loadDictionary();
 
     connect(m_speakerCompleter, QOverload<const QString &>::of(&QCompleter::activated),
@@ -55,13 +98,17 @@ Editor::Editor(QWidget *parent)
 
 
     connect(m_saveTimer, &QTimer::timeout, this, [this](){
-        if (m_autoSave && m_transcriptUrl.isValid())
+        if (m_autoSave && m_transcriptUrl.isValid() && isModified())
             transcriptSave();
     });
     m_saveTimer->start(m_saveInterval * 1000);
 
     // m_blocks.append(fromEditor(0));
-    //    undoStack =  new QUndoStack(this);
+
+    // Typed edits are recorded on the stack with the model operations, which
+    // the document's own history couldn't restore timestamps and tags for
+    m_undoStack = new QUndoStack(this);
+    document()->setUndoRedoEnabled(false);
     QString iniPath = QApplication::applicationDirPath() + "/" + "config.ini";
     settings = new QSettings(iniPath, QSettings::IniFormat);
 
@@ -73,6 +120,7 @@ Editor::Editor(QWidget *parent)
     }
 
     settings->setValue("showTimeStamps", QVariant(showTimeStamp).toString());
+    setTimeStampAreaVisible(showTimeStamp);
 
     // auto& settings = SettingsManager::getInstance();
     // showTimeStamp = settings.getShowTimeStamps();
@@ -81,7 +129,9 @@ Editor::Editor(QWidget *parent)
         "xml Files (*.xml)",
         "All Files (*)"
     };
-    m_english_dictionary = (listFromFile(QString(":/wordlists/english.txt")));
+    // The English fallback arrives through dictionaryReady() like the transcript language
+    DictionaryService::getInstance().acquire("english");
+    DictionaryService::getInstance().load("english");
 
     // debounceTimer = new QTimer(this);
     // debounceTimer->setSingleShot(true);
@@ -90,6 +140,17 @@ Editor::Editor(QWidget *parent)
     // connect(debounceTimer, &QTimer::timeout, this, &Editor::handleContentChanged);
 }
 
+Editor::~Editor()
+{
+    // The workers only hold snapshots, they just have to stop early
+    m_validationWatcher.cancel();
+    m_loadWatcher.cancel();
+
+    DictionaryService::getInstance().release("english");
+    if (!m_heldLanguage.isEmpty())
+        DictionaryService::getInstance().release(m_heldLanguage);
+}
+
 
 int countwords = 0;
 int speakercount = 0;
@@ -104,6 +165,7 @@ void Editor::setEditorFont(const QFont& font)
     m_speakerCompleter->popup()->setFont(font);
     m_transliterationCompleter->popup()->setFont(font);
     setLineNumberAreaFont(font);
+    setTimeStampAreaFont(font);
 }
 
 void Editor::setMoveAlongTimeStamps()
@@ -116,292 +178,149 @@ void Editor::setMoveAlongTimeStamps()
 }
 
 
+Highlighter::Highlighter(QTextDocument *parent)
+    : QSyntaxHighlighter(parent)
+{
+    invalidBlockFormat.setForeground(Qt::red);
+    taggedBlockFormat.setForeground(Qt::blue);
+
+    // Formats for every combination of the invalid (1), tagged (2) and edited (4) bits
+    for (int i = 1; i < 8; i++) {
+        if (i & 1) {
+            wordFormats[i].setFontUnderline(true);
+            wordFormats[i].setUnderlineColor(Qt::red);
+            wordFormats[i].setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+        }
+        if (i & 2)
+            wordFormats[i].setForeground(Qt::blue);
+        if (i & 4)
+            wordFormats[i].setBackground(Qt::yellow);
+    }
+}
+
 // Current Edit
 void Highlighter::highlightBlock(const QString& text)
 {
-    if (invalidBlockNumbers.contains(currentBlock().blockNumber())) {
-        QTextCharFormat format;
-        format.setForeground(Qt::red);
-        setFormat(0, text.size(), format);
-        return;
-    }
-    else if (taggedBlockNumbers.contains(currentBlock().blockNumber())) {
-        QTextCharFormat format;
-        format.setForeground(Qt::blue);
-        setFormat(0, text.size(), format);
-        return;
-    }
-    if (invalidWords.contains(currentBlock().blockNumber())) {
-        auto invalidWordNumbers = invalidWords.values(currentBlock().blockNumber());
-        auto speakerEnd = 0;
-        static QRegularExpression regex(R"(\{.*\}:)");
-        auto speakerMatch = regex.match(text);
-        if (speakerMatch.hasMatch())
-            speakerEnd = speakerMatch.capturedEnd();
-
-        auto words = text.mid(speakerEnd + 1).split(" ");
-
-        int start = speakerEnd;
-
-        QTextCharFormat format;
-        format.setFontUnderline(true);
-        format.setUnderlineColor(Qt::red);
-        format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
-        //to remove highlight of timestamp
-        /*if(Editor::showTimeStamp){
-            qInfo()<<"changed to true";
-            for (int i = 0; i < words.size() -1 ; i++) {
-                if (!invalidWordNumbers.contains(i))
-                    continue;
-                for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                int count = words[i].size();
-                setFormat(start + 1, count, format);
-                start = speakerEnd;
-            }
-        }else*/ {
-            for (int i = 0; i < words.size() ; i++) {
-                if (!invalidWordNumbers.contains(i))
-                    continue;
-                for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                int count = words[i].size();
-                setFormat(start + 1, count, format);
-                start = speakerEnd;
-            }}
-    }
-    if (taggedWords.contains(currentBlock().blockNumber())) {
-        auto invalidWordNumbers = taggedWords.values(currentBlock().blockNumber());
-        auto speakerEnd = 0;
-        auto speakerMatch = QRegularExpression(R"(\{.*\}:)").match(text);
-        if (speakerMatch.hasMatch())
-            speakerEnd = speakerMatch.capturedEnd();
-
-        auto words = text.mid(speakerEnd + 1).split(" ");
-
-        int start = speakerEnd;
-
-        QTextCharFormat format;
-        format.setForeground(Qt::blue);
-        //to remove highlight of timestamp
-        /*if(Editor::showTimeStamp){
-            qInfo()<<"changed to true";
-            for (int i = 0; i < words.size() -1 ; i++) {
-                if (!invalidWordNumbers.contains(i))
-                    continue;
-                for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                int count = words[i].size();
-                setFormat(start + 1, count, format);
-                start = speakerEnd;
-            }
-        }else*/ {
-            for (int i = 0; i < words.size() ; i++) {
-                if (!invalidWordNumbers.contains(i))
-                    continue;
-                for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                int count = words[i].size();
-                setFormat(start + 1, count, format);
-                start = speakerEnd;
-            }}
-    }
-    if (!editedWords.isEmpty()) {
-        auto invalidWordNumbers = editedWords.values(currentBlock().blockNumber());
-        auto speakerEnd = 0;
-        auto speakerMatch = QRegularExpression(R"(\{.*\}:)").match(text);
-        if (speakerMatch.hasMatch())
-            speakerEnd = speakerMatch.capturedEnd();
-
-        auto words = text.mid(speakerEnd + 1).split(" ");
-
-        int start = speakerEnd;
-
-        QTextCharFormat format;
-        format.setBackground(Qt::yellow);
-        //to remove highlight of timestamp
-        /*if(Editor::showTimeStamp){
-            qInfo()<<"changed to true";
-            for (int i = 0; i < words.size() -1 ; i++) {
-                if (!invalidWordNumbers.contains(i))
-                    continue;
-                for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                int count = words[i].size();
-                setFormat(start + 1, count, format);
-                start = speakerEnd;
-            }
-        }else*/ {
-            for (int i = 0; i < words.size() ; i++) {
-                if (!invalidWordNumbers.contains(i))
-                    continue;
-                for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                int count = words[i].size();
-                setFormat(start + 1, count, format);
-                start = speakerEnd;
-            }}
+    auto flags = static_cast<BlockFlags*>(currentBlockUserData());
+    if (!flags)
+        return;
+
+    int blockNumber = currentBlock().blockNumber();
+    flags->highlighted = blockNumber >= windowFirst && blockNumber <= windowLast;
+    if (!flags->highlighted)
+        return;
+
+    auto& validation = flags->validation;
+    if (validation.invalidBlock) {
+        setFormat(0, text.size(), invalidBlockFormat);
+        return;
     }
-    if (blockToHighlight == -1)
+    else if (validation.taggedBlock) {
+        setFormat(0, text.size(), taggedBlockFormat);
         return;
-    else if (currentBlock().blockNumber() == blockToHighlight) {
-        int speakerEnd = 0;
-        int lineEnd=text.length();
-        auto speakerMatch = QRegularExpression(R"(\{.*\}:)").match(text);
-        if (speakerMatch.hasMatch())
-            speakerEnd = speakerMatch.capturedEnd();
-
-        int timeStampStart = QRegularExpression(R"(\{(\d?\d:)?[0-5]?\d:[0-5]?\d(\.\d\d?\d?)?\})").match(text).capturedStart();
-        // qInfo()<<timeStampStart;
-        QTextCharFormat format;
-
-        format.setForeground(QColor(Qt::blue).lighter(120));
-        setFormat(0, speakerEnd, format);
-        format. setFontWeight(QFont::Bold);
-        setFormat(0, speakerEnd, format);
-
-
-        format.setForeground(Qt::black);
-        setFormat(speakerEnd, lineEnd, format);
-        format. setFontWeight(QFont::Bold);
-        setFormat(speakerEnd, lineEnd, format);
-
-        //        if (invalidWords.contains(currentBlock().blockNumber())) {
-        //            qInfo()<<"in";
-        //            auto invalidWordNumbers = invalidWords.values(currentBlock().blockNumber());
-        //            auto speakerEnd = 0;
-        //            auto speakerMatch = QRegularExpression(R"(\[.*]:)").match(text);
-        //            if (speakerMatch.hasMatch())
-        //                speakerEnd = speakerMatch.capturedEnd();
-
-        //            auto words = text.mid(speakerEnd + 1).split(" ");
-        //            int start = speakerEnd;
-
-        //            QTextCharFormat format;
-        //            format.setForeground(Qt::black);
-        //            setFormat(speakerEnd, lineEnd, format);
-        //            format. setFontWeight(QFont::Bold);
-        //            setFormat(speakerEnd, lineEnd, format);
-        //            format.setFontUnderline(true);
-        //            format.setUnderlineColor(Qt::red);
-        //            format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
-
-        //            for (int i = 0; i < words.size() ; i++) {
-        //                if (invalidWordNumbers.contains(i)){
-        //                    for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-        //                    int count = words[i].size();
-        //                    setFormat(start + 1, count, format);
-        //                    start = speakerEnd;
-        //                }
-        //            }
-        //        }
-        //        if (taggedWords.contains(currentBlock().blockNumber())) {
-        //            auto invalidWordNumbers = taggedWords.values(currentBlock().blockNumber());
-        //            auto speakerEnd = 0;
-        //            auto speakerMatch = QRegularExpression(R"(\[.*]:)").match(text);
-        //            if (speakerMatch.hasMatch())
-        //                speakerEnd = speakerMatch.capturedEnd();
-
-        //            auto words = text.mid(speakerEnd + 1).split(" ");
-        //            int start = speakerEnd;
-
-        //            QTextCharFormat format;
-        //            format.setForeground(Qt::black);
-        //            setFormat(speakerEnd, lineEnd, format);
-        //            format. setFontWeight(QFont::Bold);
-        //            setFormat(speakerEnd, lineEnd, format);
-        //            format.setForeground(Qt::blue);
-
-        //            for (int i = 0; i < words.size() ; i++) {
-        //                if (invalidWordNumbers.contains(i)){
-        //                    for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-        //                    int count = words[i].size();
-        //                    setFormat(start + 1, count, format);
-        //                    start = speakerEnd;
-        //                }
-        //            }
-        //        }
-        if (taggedWords.contains(currentBlock().blockNumber())||invalidWords.contains(currentBlock().blockNumber())) {
-            auto taggedWordNumbers = taggedWords.values(currentBlock().blockNumber());
-            auto invalidWordNumbers = invalidWords.values(currentBlock().blockNumber());
-            auto speakerEnd = 0;
-            auto speakerMatch = QRegularExpression(R"(\{.*\}:)").match(text);
-            if (speakerMatch.hasMatch())
-                speakerEnd = speakerMatch.capturedEnd();
-
-            auto words = text.mid(speakerEnd + 1).split(" ");
-            int start = speakerEnd;
-
-
-            QTextCharFormat format1;
-            format1.setForeground(Qt::black);
-            format1.setFontWeight(QFont::Bold);
-            format1.setFontUnderline(true);
-            format1.setUnderlineColor(Qt::red);
-            format1.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
-
-            for (int i = 0; i < words.size() ; i++) {
-                if (invalidWordNumbers.contains(i)){
-                    for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                    int count = words[i].size();
-                    setFormat(start + 1, count, format1);
-                    start = speakerEnd;
-                    // qInfo()<<"in"; // Disabled debug
-                }
-            }
+    }
 
+    auto& wordStarts = flags->wordStarts;
+    wordStarts.clear();
+    WordTokenizer tokenizer(text, WordTokenizer::wordsStart(text));
+    for (WordSpan span; tokenizer.next(span);)
+        wordStarts.append(span.start);
 
-            QTextCharFormat format2;
-            format2.setForeground(Qt::black);
-            format2. setFontWeight(QFont::Bold);
-            format2.setForeground(Qt::blue);
+    auto flagAt = [](const QBitArray& bits, int i) {
+        return i < bits.size() && bits.testBit(i);
+    };
 
-            for (int i = 0; i < words.size() ; i++) {
-                if (taggedWordNumbers.contains(i)){
-                    for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                    int count = words[i].size();
-                    setFormat(start + 1, count, format2);
-                    start = speakerEnd;
-                }
-            }
+    for (int i = 0; i < wordStarts.size(); i++) {
+        int formatIndex = (flagAt(validation.invalidWords, i) ? 1 : 0)
+                          | (flagAt(validation.taggedWords, i) ? 2 : 0)
+                          | (flagAt(validation.editedWords, i) ? 4 : 0);
+        if (!formatIndex)
+            continue;
+
+        int end = i + 1 < wordStarts.size() ? wordStarts[i + 1] - 1 : text.size();
+        setFormat(wordStarts[i], end - wordStarts[i], wordFormats[formatIndex]);
+    }
+}
 
+void Highlighter::setBlockValidation(QTextBlock textBlock, const BlockValidation& validation)
+{
+    if (!textBlock.isValid())
+        return;
 
+    auto flags = static_cast<BlockFlags*>(textBlock.userData());
+    if (flags) {
+        if (flags->validation == validation)
+            return;
+        flags->validation = validation;
+        flags->highlighted = false;
+    }
+    else {
+        if (validation.isClear())
+            return;
+        textBlock.setUserData(new BlockFlags(validation));
+    }
 
+    // Blocks outside the window are formatted when they scroll into it
+    int blockNumber = textBlock.blockNumber();
+    if (textBlock.document() == document() && blockNumber >= windowFirst && blockNumber <= windowLast)
+        scheduleRehighlight(blockNumber);
+}
 
-            QTextCharFormat format;
-            format.setForeground(Qt::black);
-            format. setFontWeight(QFont::Bold);
-            format.setForeground(Qt::blue);
-            format.setFontUnderline(true);
-            format.setUnderlineColor(Qt::red);
-            format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+void Highlighter::setWindow(int first, int last)
+{
+    if (first == windowFirst && last == windowLast)
+        return;
+    windowFirst = first;
+    windowLast = last;
 
-            for (int i = 0; i < words.size() ; i++) {
-                if (taggedWordNumbers.contains(i)&&invalidWordNumbers.contains(i))
-                {
-                    for (int j = 0; j < i; j++) start += (words[j].size() + 1);
-                    int count = words[i].size();
-                    setFormat(start + 1, count, format);
-                    start = speakerEnd;
-                }
-            }
-        }
-        format.setForeground(Qt::red);
-        setFormat(timeStampStart, text.size(), format);
-        format. setFontWeight(QFont::Light);
-        setFormat(timeStampStart, text.size(), format);
-
-        auto words = text.mid(speakerEnd + 1).split(" ");
-
-        if (wordToHighlight != -1 && wordToHighlight < words.size()) {
-            int start = speakerEnd;
-            for (int i=0; i < wordToHighlight; i++) start += (words[i].size() + 1);
-            int count = words[wordToHighlight].size();
-
-            format.setFontUnderline(true);
-            format.setUnderlineColor(Qt::green);
-            format.setUnderlineStyle(QTextCharFormat::DashUnderline);
-            format.setForeground(Qt::green);
-            setFormat(start + 1, count, format);
-        }
+    if (!document())
+        return;
+
+    auto textBlock = document()->findBlockByNumber(qMax(first, 0));
+    for (int i = qMax(first, 0); i <= last && textBlock.isValid(); i++, textBlock = textBlock.next()) {
+        auto flags = static_cast<BlockFlags*>(textBlock.userData());
+        if (flags && !flags->highlighted)
+            scheduleRehighlight(i);
+    }
+}
+
+void Highlighter::scheduleRehighlight(int blockNumber)
+{
+    if (blockNumber < 0 || !document())
+        return;
+
+    scheduledBlocks.insert(blockNumber);
+
+    if (!rehighlightQueued) {
+        rehighlightQueued = true;
+        QMetaObject::invokeMethod(this, &Highlighter::rehighlightScheduledBlocks, Qt::QueuedConnection);
     }
 }
 
+void Highlighter::rehighlightScheduledBlocks()
+{
+    rehighlightQueued = false;
+
+    if (!document() || scheduledBlocks.isEmpty()) {
+        scheduledBlocks.clear();
+        return;
+    }
+
+    auto blockNumbers = scheduledBlocks.values();
+    std::sort(blockNumbers.begin(), blockNumbers.end());
+    scheduledBlocks.clear();
+
+    int rehighlightedBlocks = 0;
+    for (auto blockNumber: std::as_const(blockNumbers)) {
+        auto textBlock = document()->findBlockByNumber(blockNumber);
+        if (!textBlock.isValid())
+            continue;
+        rehighlightBlock(textBlock);
+        rehighlightedBlocks++;
+    }
 
+    emit blocksRehighlighted(rehighlightedBlocks);
+}
 
 void Editor::mousePressEvent(QMouseEvent *e)
 {
@@ -412,6 +331,31 @@ void Editor::mousePressEvent(QMouseEvent *e)
 
 void Editor::keyPressEvent(QKeyEvent *event)
 {
+    if (event->matches(QKeySequence::Undo)) {
+        undo();
+        return;
+    }
+    if (event->matches(QKeySequence::Redo)) {
+        redo();
+        return;
+    }
+
+    // Keys act on the cursor, so its line is paged in first
+    switch (event->key()) {
+        case Qt::Key_Shift:
+        case Qt::Key_Control:
+        case Qt::Key_Alt:
+        case Qt::Key_AltGr:
+        case Qt::Key_Meta:
+            break;
+        default:
+            restoreCursor();
+    }
+    if (event->matches(QKeySequence::MoveToStartOfDocument) || event->matches(QKeySequence::SelectStartOfDocument))
+        showBlock(0);
+    else if (event->matches(QKeySequence::MoveToEndOfDocument) || event->matches(QKeySequence::SelectEndOfDocument))
+        showBlock(m_blocks.size() - 1);
+
     if (event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_R)
         createChangeSpeakerDialog();
     else if (event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_T)
@@ -423,13 +367,11 @@ void Editor::keyPressEvent(QKeyEvent *event)
         //Qt6
         // const bool containsSpeakerBraces = blockText.leftRef(blockText.indexOf(" ")).contains("]:");
         const bool containsSpeakerBraces = blockText.left(blockText.indexOf(" ")).contains("}:");
-        const bool containsTimeStamp = blockText.trimmed() != "" && blockText.trimmed().back() == '}';
         bool isAWordUnderCursor = false;
         int wordNumber = 0;
 
         if ((containsSpeakerBraces && textTillCursor.count(" ") > 0) || !containsSpeakerBraces) {
-            if (m_blocks.size() > textCursor().blockNumber() &&
-                !(containsTimeStamp && textTillCursor.count(" ") == blockText.count(" "))) {
+            if (m_blocks.size() > cursorBlockNumber()) {
                 isAWordUnderCursor = true;
 
                 if (containsSpeakerBraces) {
@@ -441,17 +383,17 @@ void Editor::keyPressEvent(QKeyEvent *event)
             }
         }
 
-        markWordAsCorrect(textCursor().blockNumber(), wordNumber);
+        markWordAsCorrect(cursorBlockNumber(), wordNumber);
     }
     else if (event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_I){
         // qInfo()<<"doubtful"; // Disabled debug
-        int blocknumber = textCursor().blockNumber();
+        int blocknumber = cursorBlockNumber();
         int wordNumber = textCursor().block().text().left(textCursor().positionInBlock()).trimmed().count(" ");
         // qInfo()<<blocknumber; // Disabled debug
         // qInfo()<<wordNumber; // Disabled debug
 
         if (blocknumber > m_blocks.size() || blocknumber < 0 ||
-            wordNumber <= 0 || wordNumber > m_blocks[blocknumber].words.size()) {
+            wordNumber <= 0 || wordNumber > m_blocks[blocknumber].wordCount()) {
             event->ignore();
             return;
         }
@@ -461,11 +403,9 @@ void Editor::keyPressEvent(QKeyEvent *event)
         //     qInfo()<<"marked";
         // }
 
-        QTextBlock block = document()->findBlockByNumber(blocknumber);
-        QTextCursor cursor(document()->findBlockByNumber(blocknumber));
         setContent();
 
-        cursor.setPosition(block.position());
+        auto cursor = blockCursor(blocknumber);
         cursor.movePosition(QTextCursor::NextWord, QTextCursor::MoveAnchor, wordNumber - 1);
         setTextCursor(cursor);
         centerCursor();
@@ -529,82 +469,73 @@ void Editor::keyPressEvent(QKeyEvent *event)
         completionPrefix = blockText.left(blockText.indexOf(" "));
         completionPrefix = completionPrefix.mid(1, completionPrefix.size() - 3);
 
-        QList<QString> speakers;
-        for (auto& a_block: std::as_const(m_blocks))
-            if (!speakers.contains(a_block.speaker) && a_block.speaker != "")
-                speakers.append(a_block.speaker);
-
-        m_speakerCompleter->setModel(new QStringListModel(speakers, m_speakerCompleter));
+        if (m_completedSpeakersRevision != m_speakerIndex.revision()) {
+            m_completedSpeakersRevision = m_speakerIndex.revision();
+            static_cast<QStringListModel*>(m_speakerCompleter->model())->setStringList(m_speakerIndex.speakers());
+        }
     }
     else {
-        if(!showTimeStamp){
-            QString blockText = textCursor().block().text();
-            QString textTillCursor = blockText.left(textCursor().positionInBlock());
-
-            const bool containsSpeakerBraces = blockText.left(blockText.indexOf(" ")).contains("}:");
-            const bool containsTimeStamp = blockText.trimmed() != "" && blockText.trimmed().back() == '}';
-            bool isAWordUnderCursor = false;
-            int wordNumber = 0;
-
-            if ((containsSpeakerBraces && textTillCursor.count(" ") > 0) || !containsSpeakerBraces) {
-                if (m_blocks.size() > textCursor().blockNumber() &&
-                    !(containsTimeStamp && textTillCursor.count(" ") == blockText.count(" "))) {
-                    isAWordUnderCursor = true;
-
-                    if (containsSpeakerBraces) {
-                        auto textWithoutSpeaker = textTillCursor.split("}:").last();
-                        wordNumber = textWithoutSpeaker.trimmed().count(" ");
-                    }
-                    else
-                        wordNumber = textTillCursor.trimmed().count(" ");
-                }
-            }
-            if(m_blocks[textCursor().block().blockNumber()].words[wordNumber].text.size()>2){
-                QString text = m_blocks[textCursor().blockNumber()].words[wordNumber].text.toLower();
-                QString text2 = m_blocks[textCursor().blockNumber()].words[wordNumber].text;
-                text=text.trimmed();
-                text2=text.trimmed();
-                //            qInfo()<<text;
-                QString val;
-                QFile file;
-                file.setFileName("replacedTextDictonary.json");
-                file.open(QIODevice::ReadOnly | QIODevice::Text);
-                val = file.readAll();
-                file.close();
-                QJsonDocument d = QJsonDocument::fromJson(val.toUtf8());
-                QJsonObject sett2 = d.object();
-                QJsonArray value = sett2[text].toArray();
-                QStringList allSuggestions;
-                if(value.size()>0){
-                    for( auto i : value){
-                        allSuggestions<< i.toString();
-                    }
-                    //                qInfo()<<allSuggestions;
-                    QMenu *sugg=new QMenu;
-                    for(auto i:allSuggestions ){
-                        auto readmeJson = new QAction;
-                        readmeJson->setText(i);
-                        connect(readmeJson, &QAction::triggered, this,[this,i]()
-                                {
-                                    suggest(i);
-                                });
-                        sugg->addAction(readmeJson);
-                    }
-                    //                 sugg->setMaximumHeight(50);
-                    sugg->setStyleSheet("QMenu { menu-scrollable: 1; }");
+        QString blockText = textCursor().block().text();
+        QString textTillCursor = blockText.left(textCursor().positionInBlock());
+
+        const bool containsSpeakerBraces = blockText.left(blockText.indexOf(" ")).contains("}:");
+        bool isAWordUnderCursor = false;
+        int wordNumber = 0;
 
+        if ((containsSpeakerBraces && textTillCursor.count(" ") > 0) || !containsSpeakerBraces) {
+            if (m_blocks.size() > cursorBlockNumber()) {
+                isAWordUnderCursor = true;
 
-                    QPoint x; x.setX(QCursor::pos().rx()+2);x.setY(QCursor::pos().ry());
-                    sugg->exec(x);
-                    //                delete sugg;
+                if (containsSpeakerBraces) {
+                    auto textWithoutSpeaker = textTillCursor.split("}:").last();
+                    wordNumber = textWithoutSpeaker.trimmed().count(" ");
                 }
+                else
+                    wordNumber = textTillCursor.trimmed().count(" ");
             }
         }
-        if(showTimeStamp)
-            if (m_blocks[textCursor().blockNumber()].timeStamp.isValid()
-                && textTillCursor.count(" ") == blockText.count(" "))
-                return;
+        // Timestamps aren't part of the line, so the suggestions apply with or without them shown
+        if(isAWordUnderCursor && wordNumber < m_blocks[cursorBlockNumber()].wordCount()
+            && m_blocks[cursorBlockNumber()].wordText(wordNumber).size()>2){
+            QString text = m_blocks[cursorBlockNumber()].wordText(wordNumber).toString().toLower();
+            QString text2 = m_blocks[cursorBlockNumber()].wordText(wordNumber).toString();
+            text=text.trimmed();
+            text2=text.trimmed();
+            //            qInfo()<<text;
+            QString val;
+            QFile file;
+            file.setFileName("replacedTextDictonary.json");
+            file.open(QIODevice::ReadOnly | QIODevice::Text);
+            val = file.readAll();
+            file.close();
+            QJsonDocument d = QJsonDocument::fromJson(val.toUtf8());
+            QJsonObject sett2 = d.object();
+            QJsonArray value = sett2[text].toArray();
+            QStringList allSuggestions;
+            if(value.size()>0){
+                for( auto i : value){
+                    allSuggestions<< i.toString();
+                }
+                //                qInfo()<<allSuggestions;
+                QMenu *sugg=new QMenu;
+                for(auto i:allSuggestions ){
+                    auto readmeJson = new QAction;
+                    readmeJson->setText(i);
+                    connect(readmeJson, &QAction::triggered, this,[this,i]()
+                            {
+                                suggest(i);
+                            });
+                    sugg->addAction(readmeJson);
+                }
+                //                 sugg->setMaximumHeight(50);
+                sugg->setStyleSheet("QMenu { menu-scrollable: 1; }");
 
+
+                QPoint x; x.setX(QCursor::pos().rx()+2);x.setY(QCursor::pos().ry());
+                sugg->exec(x);
+                //                delete sugg;
+            }
+        }
         int index = textTillCursor.count(" ");
         completionPrefix = blockText.split(" ")[index];
 
@@ -648,6 +579,14 @@ void Editor::keyPressEvent(QKeyEvent *event)
     }
 
 
+    if (m_completer == m_textCompleter) {
+        QString keyBuffer;
+        m_completionModel->setPrefix(WordTokenizer::normalize(completionPrefix, keyBuffer));
+        if (!m_completionModel->rowCount()) {
+            m_completer->popup()->hide();
+            return;
+        }
+    }
     if (m_completer != m_transliterationCompleter && completionPrefix != m_completer->completionPrefix()) {
         m_completer->setCompletionPrefix(completionPrefix);
     }
@@ -661,19 +600,18 @@ void Editor::keyPressEvent(QKeyEvent *event)
 
 void Editor::contextMenuEvent(QContextMenuEvent *event)
 {
+    restoreCursor();
     QMenu *menu = createStandardContextMenu();
 
     QString blockText = textCursor().block().text();
     QString textTillCursor = blockText.left(textCursor().positionInBlock());
 
     const bool containsSpeakerBraces = blockText.left(blockText.indexOf(" ")).contains("}:");
-    const bool containsTimeStamp = blockText.trimmed() != "" && blockText.trimmed().back() == '}';
     bool isAWordUnderCursor = false;
     int wordNumber = 0;
 
     if ((containsSpeakerBraces && textTillCursor.count(" ") > 0) || !containsSpeakerBraces) {
-        if (m_blocks.size() > textCursor().blockNumber() &&
-            !(containsTimeStamp && textTillCursor.count(" ") == blockText.count(" "))) {
+        if (m_blocks.size() > cursorBlockNumber()) {
             isAWordUnderCursor = true;
 
             if (containsSpeakerBraces) {
@@ -686,7 +624,9 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
     }
 
     if (isAWordUnderCursor) {
-
+        QStringList corrections;
+        if (isWordFlaggedInvalid(cursorBlockNumber(), wordNumber))
+            corrections = spellingSuggestions(m_blocks[cursorBlockNumber()].wordText(wordNumber).toString());
 
         auto markAsCorrectAction = new QAction;
         markAsCorrectAction->setText("Mark As Correct");
@@ -694,12 +634,12 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
         connect(markAsCorrectAction, &QAction::triggered, this,
                 [this, wordNumber]()
                 {
-                    markWordAsCorrect(textCursor().blockNumber(), wordNumber);
+                    markWordAsCorrect(cursorBlockNumber(), wordNumber);
                 });
         menu->addAction(markAsCorrectAction);
         //added suggestions
-        QString text = m_blocks[textCursor().blockNumber()].words[wordNumber].text.toLower();
-        QString text2 = m_blocks[textCursor().blockNumber()].words[wordNumber].text;
+        QString text = m_blocks[cursorBlockNumber()].wordText(wordNumber).toString().toLower();
+        QString text2 = m_blocks[cursorBlockNumber()].wordText(wordNumber).toString();
         text=text.trimmed();
         text2=text.trimmed();
         //        qInfo()<<text;
@@ -743,6 +683,15 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
 
 
         QMenu *sugg=menu->addMenu(tr("&Suggestions"));
+        for (auto& correction: std::as_const(corrections)) {
+            auto correctionAction = sugg->addAction(correction);
+            connect(correctionAction, &QAction::triggered, this, [this, correction]()
+                    {
+                        suggest(correction);
+                    });
+        }
+        if (!corrections.isEmpty() && !allSuggestions.isEmpty())
+            sugg->addSeparator();
         for(auto i:allSuggestions ){
             auto readmeJson = new QAction;
             readmeJson->setText(i);
@@ -770,6 +719,14 @@ void Editor::contextMenuEvent(QContextMenuEvent *event)
     delete menu;
 }
 
+void Editor::insertFromMimeData(const QMimeData *source)
+{
+    // The document reports the insertion before this returns
+    m_pasting = true;
+    TextEditor::insertFromMimeData(source);
+    m_pasting = false;
+}
+
 void Editor::transcriptOpen()
 {
     QFileDialog fileDialog(this);
@@ -790,32 +747,52 @@ void Editor::transcriptOpen()
 
 void Editor::transcriptSave()
 {
-
+    // Only part of the transcript is in m_blocks until it is loaded
+    if (m_loading) {
+        emit message("Transcript is still loading");
+        return;
+    }
 
     if (m_transcriptUrl.isEmpty())
         transcriptSaveAs();
-    else {
-        auto *file = new QFile(m_transcriptUrl.toLocalFile());
-        if (!file->open(QIODevice::WriteOnly | QFile::Truncate)) {
-            emit message(file->errorString());
-            return;
-        }
-        saveXml(file);
-        emit message("File Saved " + m_transcriptUrl.toLocalFile());
+    else if (!isModified()) {
+        emit message("No changes to save");
+        return;
     }
+    else
+        saveTranscript(m_transcriptUrl.toLocalFile());
 
+    startAlignment();
+}
 
-    //QStringList list = str.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+void Editor::startAlignment()
+{
+    // A run requested while one is going starts once it finishes, with the latest text
+    if (m_aligning) {
+        m_alignmentQueued = true;
+        return;
+    }
+    m_aligning = true;
 
+    QtConcurrent::run(&Editor::alignTranscript, m_blocks, fileBeforeSave, fileAfterSave, !realTimeDataSaver)
+        .then(this, [this](QString errorString) {
+            m_aligning = false;
+            if (!errorString.isEmpty())
+                QMessageBox::critical(this, "Error", errorString);
+            if (std::exchange(m_alignmentQueued, false))
+                startAlignment();
+        });
+}
 
+QString Editor::alignTranscript(QVector<block> blocks, QString fileBeforeSave, QString fileAfterSave, bool runAligner)
+{
     QFile final(fileAfterSave);
     if(!final.open(QIODevice::OpenModeFlag::WriteOnly)){
-        QMessageBox::critical(this,"Error",final.errorString());
-        return;
+        return final.errorString();
     }
     QString x("");
-    for (auto& a_block: std::as_const(m_blocks)) {
-        auto blockText = a_block.text + " " ;
+    for (auto& a_block: std::as_const(blocks)) {
+        auto blockText = a_block.text() + " " ;
         //            qInfo()<<a_block.text;
         x.append(blockText + "\n");
     }
@@ -830,8 +807,7 @@ void Editor::transcriptSave()
         QFile aligner(":/alignment.py");
         if(!aligner.open(QIODevice::OpenModeFlag::ReadOnly)){
             qDebug() << "From myAlgn - 1";
-            QMessageBox::critical(this,"Error",aligner.errorString());
-            return;
+            return aligner.errorString();
         }
         aligner.seek(0);
         QString cp=aligner.readAll();
@@ -839,8 +815,7 @@ void Editor::transcriptSave()
 
         if(!mapper.open(QIODevice::OpenModeFlag::WriteOnly | QIODevice::Truncate)){
             qDebug() << "From myAlgn - 2";
-            QMessageBox::critical(this,"Error",mapper.errorString());
-            return;
+            return mapper.errorString();
         }
         mapper.write(QByteArray(cp.toUtf8()));
         mapper.close();
@@ -854,8 +829,7 @@ void Editor::transcriptSave()
         QFile repDict("replacedTextDictonary.json");
         if(!repDict.open(QIODevice::OpenModeFlag::WriteOnly|QIODevice::Truncate)){
             qDebug() << "From replacedTextDictonary - 1";
-            QMessageBox::critical(this,"Error",repDict.errorString());
-            return;
+            return repDict.errorString();
         }
         QString init="{}";
         repDict.write(QByteArray(init.toUtf8()));
@@ -875,19 +849,20 @@ void Editor::transcriptSave()
                                + " "+finalFileInfo.absoluteFilePath().replace(" ", "\\ ").toStdString()
                                + " "+repDictFileInfo.absoluteFilePath().replace(" ", "\\ ").toStdString();
 
-    if(!realTimeDataSaver){
+    if(runAligner){
         result = system(alignmentstr.c_str());
     }
     // qInfo()<<result; // Disabled debug
 
+    return {};
 }
 
 void Editor::transcriptSaveAs()
 {
-
-    auto initialShowTimeStamp=showTimeStamp;
-    showTimeStamp=true;
-    setContent();
+    if (m_loading) {
+        emit message("Transcript is still loading");
+        return;
+    }
 
     QFileDialog fileDialog(this);
     fileDialog.setAcceptMode(QFileDialog::AcceptSave);
@@ -903,18 +878,10 @@ void Editor::transcriptSaveAs()
             if (!filePath.endsWith(".xml", Qt::CaseInsensitive)) {
                 filePath += ".xml";
             }
-            auto *file = new QFile(fileUrl.toLocalFile());
-            if (!file->open(QIODevice::WriteOnly)) {
-                emit message(file->errorString());
-                return;
-            }
-            m_transcriptUrl = fileUrl;
-            saveXml(file);
-            emit message("File Saved " + fileUrl.toLocalFile());
+            m_transcriptUrl = QUrl::fromLocalFile(filePath);
+            saveTranscript(filePath);
         }
     }
-    showTimeStamp=initialShowTimeStamp;
-    setContent();
 }
 
 void Editor::transcriptClose()
@@ -926,8 +893,13 @@ void Editor::transcriptClose()
 
 
     emit message("Closing file " + m_transcriptUrl.toLocalFile());
+    m_loadWatcher.cancel();
+    m_loading = false;
+    setReadOnly(false);
+    emit loadProgress(100);
     m_transcriptUrl.clear();
     m_blocks.clear();
+    m_undoStack->clear();
     m_transcriptLang = "english";
 
     loadDictionary();
@@ -937,68 +909,99 @@ void Editor::transcriptClose()
 void Editor::showBlocksFromData()
 {
     for (auto& m_block: std::as_const(m_blocks)) {
-        qDebug() << m_block.timeStamp << m_block.speaker << m_block.text << m_block.tagList;
-        for (auto& m_word: std::as_const(m_block.words)) {
-            qDebug() << "   " << m_word.timeStamp << m_word.text << m_word.tagList;
+        qDebug() << m_block.timeStamp() << m_block.speaker << m_block.text() << m_block.tagList.toStringList();
+        for (auto& m_word: m_block.words()) {
+            qDebug() << "   " << m_word.timeStamp() << m_word.text << m_word.tagList.toStringList();
         }
     }
 }
 
 void Editor::highlightTranscript(const QTime& elapsedTime)
 {
-    int blockToHighlight = -1;
+    int blockToHighlight = m_timeIndex.blockAt(elapsedTime);
     int wordToHighlight = -1;
 
-    if (!m_blocks.isEmpty()) {
-
-        for (int i=0; i < m_blocks.size(); i++) {
-
-            if(m_blocks[i].timeStamp.isValid()){if (m_blocks[i].timeStamp > elapsedTime) {
-
-
-                    QTextBlock tb = this->document()->findBlockByNumber(i);//block number
-                    QString s = tb.text();
-                    blockToHighlight=tb.blockNumber();
-                    break;
-                }}
-
-        }
-
-    }
     //qInfo()<<blockToHighlight;
-    if (blockToHighlight != highlightedBlock ) {
+    bool blockChanged = blockToHighlight != highlightedBlock;
+    if (blockChanged) {
         highlightedBlock = blockToHighlight;
-        if (!m_highlighter)
-            m_highlighter = new Highlighter(document());
-
-        m_highlighter->setBlockToHighlight(blockToHighlight);
 
         if(moveAlongTimeStamps){
-            QTextCursor cursor(this->document()->findBlockByNumber(blockToHighlight));
+            QTextCursor cursor = blockCursor(blockToHighlight);
             this->setTextCursor(cursor);
         }
 
-
-        if (blockToHighlight == -1)
+        if (blockToHighlight == -1) {
+            updatePlaybackHighlight();
             return;
+        }
     }
     if (blockToHighlight == -1)
         return;
 
-    emit sendBlockText(m_blocks[blockToHighlight].text);
+    emit sendBlockText(m_blocks[blockToHighlight].text());
 
-    for (int i = 0; i < m_blocks[blockToHighlight].words.size(); i++) {
-        if (m_blocks[blockToHighlight].words[i].timeStamp > elapsedTime) {
-            wordToHighlight = i;
-            break;
-        }
-    }
+    wordToHighlight = m_timeIndex.wordAt(blockToHighlight, elapsedTime);
 
-    if (wordToHighlight != highlightedWord) {
+    if (blockChanged || wordToHighlight != highlightedWord) {
         highlightedWord = wordToHighlight;
-        m_highlighter->setWordToHighlight(wordToHighlight);
+        updatePlaybackHighlight();
+    }
+}
+
+void Editor::updatePlaybackHighlight()
+{
+    QList<QTextEdit::ExtraSelection> selections;
+    auto textBlock = findTextBlock(highlightedBlock);
+
+    // Also when the block is paged out, the gutter is only drawn for lines in the document
+    if (highlightedBlock == -1 || !textBlock.isValid()) {
+        setPlaybackSelections(selections);
+        setHighlightedTimeStamp(highlightedBlock);
+        return;
+    }
+    setHighlightedTimeStamp(highlightedBlock);
+
+    auto text = textBlock.text();
+    int speakerEnd = WordTokenizer::speakerEnd(text);
+
+    auto addSelection = [&](int start, int length, const QTextCharFormat& format) {
+        if (length <= 0)
+            return;
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(textBlock);
+        selection.cursor.setPosition(textBlock.position() + start);
+        selection.cursor.setPosition(textBlock.position() + start + length, QTextCursor::KeepAnchor);
+        selection.format = format;
+        selections.append(selection);
+    };
+
+    QTextCharFormat lineFormat;
+    lineFormat.setBackground(QColor(225, 235, 250));
+    addSelection(0, text.size(), lineFormat);
+
+    QTextCharFormat speakerFormat;
+    speakerFormat.setForeground(QColor(Qt::blue).lighter(120));
+    addSelection(0, speakerEnd, speakerFormat);
+
+    WordSpan highlightedSpan;
+    bool wordFound = false;
+    if (highlightedWord != -1) {
+        WordTokenizer tokenizer(text, WordTokenizer::wordsStart(text));
+        for (int i = 0; i <= highlightedWord && (wordFound = tokenizer.next(highlightedSpan)); i++) {}
+    }
+    if (wordFound) {
+
+        QTextCharFormat wordFormat;
+        wordFormat.setForeground(Qt::darkGreen);
+        wordFormat.setBackground(QColor(200, 240, 200));
+        wordFormat.setFontUnderline(true);
+        wordFormat.setUnderlineColor(Qt::green);
+        wordFormat.setUnderlineStyle(QTextCharFormat::DashUnderline);
+        addSelection(highlightedSpan.start, highlightedSpan.text.size(), wordFormat);
     }
 
+    setPlaybackSelections(selections);
 }
 
 void Editor::addCustomDictonary()
@@ -1013,22 +1016,57 @@ void Editor::addCustomDictonary()
         return;
     }
 
-    loadDictionary();
+    auto wordsFromCustomDictonary = listFromFile(m_customDictonaryPath);
+    QString keyBuffer;
+    for (auto& word : wordsFromCustomDictonary) {
+        word = WordTokenizer::normalize(word, keyBuffer).toString();
+    }
+
+    // The words are merged once the dictionary arrives through dictionaryReady()
+    if (m_customDictionaryLanguage != m_transcriptLang)
+        m_customDictionaryWords.clear();
+    m_customDictionaryLanguage = m_transcriptLang;
+    m_customDictionaryWords.append(wordsFromCustomDictonary);
+    DictionaryService::getInstance().load(m_transcriptLang);
 }
 
-QTime Editor::getTime(const QString& text)
+void Editor::mergeCustomDictionary(const QString& language, const WordList& dictionary)
 {
-    if (text.contains(".")) {
-        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s.z");
-        return QTime::fromString(text, "m:s.z");
-    }
-    else {
-        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s");
-        return QTime::fromString(text, "m:s");
-    }
+    auto words = std::exchange(m_customDictionaryWords, QStringList());
+    m_customDictionaryLanguage.clear();
+
+    QtConcurrent::run([language, dictionary, words]() {
+        auto combinedDictionary = dictionary.merged(words);
+
+        QDir languageFolder("Dictonaries/"+language);
+        if(!languageFolder.exists()){
+            languageFolder.mkpath(".");
+        }
+        auto combinedFileName = languageFolder.filePath(language+"combined");
+
+        QFile file2(combinedFileName + ".txt");
+        if(!file2.open(QIODevice::OpenModeFlag::WriteOnly|QIODevice::Truncate)){
+            qDebug() << "From Dictionary - 1";
+            return qMakePair(combinedDictionary, file2.errorString());
+        }
+        for (qsizetype i = 0; i < combinedDictionary.size(); i++) {
+            file2.write(combinedDictionary.at(i).toUtf8());
+            file2.write("\n");
+        }
+        file2.close();
+        if (!combinedDictionary.save(combinedFileName + ".vwl"))
+            qDebug() << "From Dictionary - 2";
+        return qMakePair(combinedDictionary, QString());
+    }).then(this, [this, language](QPair<WordList, QString> result) {
+        if (!result.second.isEmpty()) {
+            QMessageBox::critical(this,"Error",result.second);
+            return;
+        }
+        DictionaryService::getInstance().update(language, result.first);
+    });
 }
 
-word Editor::makeWord(const QTime& t, const QString& s, const QStringList& tagList, const QString& isEdited)
+word Editor::makeWord(const QTime& t, const QString& s, const TagList& tagList, bool isEdited)
 {
     word w = {t, s, tagList, isEdited};
     return w;
@@ -1047,28 +1085,97 @@ QCompleter* Editor::makeCompleter()
 
 void Editor::loadTranscriptFromUrl(QUrl *fileUrl)
 {
+    QFileInfo filedir(fileUrl->toLocalFile());
+    if (!filedir.isReadable()) {
+        qDebug() << "From loadTranscriptFromUrl - 1";
+        emit message(tr("Cannot open %1").arg(fileUrl->toLocalFile()));
+        return;
+    }
     m_transcriptUrl = *fileUrl;
-    QFile transcriptFile(fileUrl->toLocalFile());
-    QFileInfo filedir(transcriptFile);
     QString dirInString=filedir.dir().path();
     // SettingsManager::getInstance().setTranscriptsDirectory("transcriptDir");
     settings->setValue("transcriptDir", dirInString);
-    if (!transcriptFile.open(QIODevice::ReadOnly)) {
-        qDebug() << "From loadTranscriptFromUrl - 1";
-        emit message(transcriptFile.errorString());
+
+    m_saveTimer->stop();
+
+    // A load still running for the previous file is dropped by its generation
+    m_loadWatcher.cancel();
+    m_loading = true;
+    m_blocks.clear();
+    m_blockValidation.clear();
+    m_undoStack->clear();
+    setContent();
+    // Lines edited while the rest loads count as changes
+    m_savedRevision = m_revision;
+    setReadOnly(true);
+
+    emit message("Loading transcript: " + fileUrl->fileName(), 0);
+    emit loadProgress(0);
+    m_loadWatcher.setFuture(QtConcurrent::run(&TranscriptReader::loadTranscript,
+                                              ++m_loadGeneration,
+                                              fileUrl->toLocalFile()));
+}
+
+void Editor::applyLoadedChunks(int begin, int end)
+{
+    for (int i = begin; i < end; i++) {
+        auto chunk = m_loadWatcher.resultAt(i);
+        if (chunk.generation != m_loadGeneration || !m_loading)
+            continue;
+
+        // The first chunk brings the language, the dictionary loads meanwhile
+        if (i == 0) {
+            m_transcriptLang = chunk.language.isEmpty() ? "english" : chunk.language;
+            loadDictionary();
+        }
+
+        if (!chunk.blocks.isEmpty())
+            appendLoadedBlocks(chunk.blocks);
+        setReadOnly(false);
+        emit loadProgress(chunk.progress);
+
+        if (chunk.finished)
+            finishLoading(chunk.errorString);
+        else
+            emit message(QString("Loading transcript: %1 (%2%)").arg(m_transcriptUrl.fileName()).arg(chunk.progress), 0);
+    }
+}
+
+void Editor::appendLoadedBlocks(const QVector<block>& blocks)
+{
+    // The empty document already has a line, the first blocks replace it
+    if (m_blocks.isEmpty()) {
+        m_blocks = blocks;
+        setContent();
         return;
     }
 
-    m_saveTimer->stop();
+    int first = m_blocks.size();
+    m_blocks.append(blocks);
+    m_blockValidation.resize(m_blocks.size());
+    for (int i = first; i < m_blocks.size(); i++)
+        indexBlock(i);
+    m_timeIndex.update(m_blocks, first);
 
-    loadTranscriptData(transcriptFile);
+    // Paged in once the view gets to them, the lines shown stay editable
+    updateBlockScrollBar();
+    updateLineNumbers();
+    updateWindow();
+}
 
-    if (m_transcriptLang == "")
-        m_transcriptLang = "english";
+void Editor::finishLoading(const QString& errorString)
+{
+    m_loading = false;
+    setReadOnly(false);
+    emit loadProgress(100);
 
-    loadDictionary();
+    if (!errorString.isEmpty()) {
+        qDebug() << "From finishLoading - 1";
+        emit message(errorString);
+    }
 
-    setContent();
+    // Validated once every block is there, visible blocks first
+    startValidation();
     //*********************Inserting into file********************************
     QFile initial(fileBeforeSave);
     if(!initial.open(QIODevice::OpenModeFlag::ReadWrite)){
@@ -1078,7 +1185,7 @@ void Editor::loadTranscriptFromUrl(QUrl *fileUrl)
     }
     QString x("");
     for (auto& a_block: std::as_const(m_blocks)) {
-        auto blockText =  a_block.text + " " ;
+        auto blockText =  a_block.text() + " " ;
         x.append(blockText + "\n");
     }
 
@@ -1088,206 +1195,138 @@ void Editor::loadTranscriptFromUrl(QUrl *fileUrl)
 
     //*********************************************************
 
-    if (m_transcriptLang != "")
-        emit message("Opened transcript: " + fileUrl->fileName() + " Language: " + m_transcriptLang);
-    else
-        emit message("Opened transcript: " + fileUrl->fileName());
-    emit openMessage(fileUrl->fileName());
+    if (errorString.isEmpty()) {
+        if (m_transcriptLang != "")
+            emit message("Opened transcript: " + m_transcriptUrl.fileName() + " Language: " + m_transcriptLang);
+        else
+            emit message("Opened transcript: " + m_transcriptUrl.fileName());
+    }
+    emit openMessage(m_transcriptUrl.fileName());
 
     m_saveTimer->start(m_saveInterval * 1000);
 }
 
-block Editor::fromEditor(qint64 blockNumber) const
+block Editor::fromEditor(qint64 blockNumber, bool parseTimeStamp) const
 {
-    QTime timeStamp;
-    QVector<word> words;
-    QString text, speaker, blockText(document()->findBlockByNumber(blockNumber).text());
-
-    QRegularExpressionMatch match = timeStampExp.match(blockText);
-    if (match.hasMatch()) {
-        QString matchedTimeStampString = match.captured();
-        if (blockText.mid(match.capturedEnd()).trimmed() == "") {
-            // Get timestamp for string after removing the enclosing []
-            timeStamp = getTime(matchedTimeStampString.mid(1,matchedTimeStampString.size() - 2));
-            text = blockText.split(matchedTimeStampString)[0];
+    // Timestamps are drawn in the gutter, a line only holds the speaker and the text
+    qint64 time = TranscriptTime::noTime;
+    QString blockText(document()->findBlockByNumber(blockNumber).text());
+
+    QStringView speaker, text;
+    parseLine(blockText, speaker, text);
+
+    // Text exported with timestamps ends its lines with "{hh:mm:ss.zzz}"
+    if (parseTimeStamp && text.endsWith(u'}')) {
+        auto timeStampStart = text.lastIndexOf(u'{');
+        if (timeStampStart >= 0) {
+            time = TimeCodec::parseMilliseconds(text.sliced(timeStampStart + 1, text.size() - timeStampStart - 2), true);
+            if (time != TranscriptTime::noTime)
+                text = text.left(timeStampStart).trimmed();
         }
-    }else{
-        text = blockText.trimmed();
     }
 
-    match = speakerExp.match(blockText);
-    if (match.hasMatch()) {
-        speaker = match.captured();
-        if (text != "")
-            text = text.split(speaker)[1];
-        speaker = speaker.left(speaker.size() - 2);
-        speaker = speaker.right(speaker.size() - 1);
+    // Every word of the line is typed, as far as the data knows
+    block b;
+    b.time = time;
+    b.speaker = speaker.toString();
+    b.setText(text);
+    return b;
+}
+
+void Editor::parseLine(QStringView line, QStringView& speaker, QStringView& text)
+{
+    auto speakerEnd = WordTokenizer::speakerEnd(line);
+    if (speakerEnd) {
+        auto speakerStart = line.indexOf(u'{');
+        speaker = line.sliced(speakerStart + 1, speakerEnd - speakerStart - 3);
+        text = line.sliced(speakerEnd).trimmed();
     }
+    else {
+        speaker = {};
+        text = line.trimmed();
+    }
+}
 
-    if (text == "")
-        text = blockText.trimmed();
-    else
-        text = text.trimmed();
+bool Editor::lineMatchesBlock(QStringView line, const block& a_block)
+{
+    QStringView speaker, text;
+    parseLine(line, speaker, text);
+    return speaker == a_block.speaker && text == QStringView(a_block.text()).trimmed();
+}
 
-    auto list = text.split(" ");
-    //checking
-    for (auto& m_word: std::as_const(list)) {
-        words.append(makeWord(QTime(), m_word, QStringList(), "true"));
-    }
+void Editor::stripPastedTimeStamps(const QVector<int>& blockNumbers)
+{
+    if (blockNumbers.isEmpty())
+        return;
 
-    block b = {timeStamp, text, speaker, QStringList(), words};
-    return b;
+    // The document can't be edited while it reports the paste, and the lines
+    // are only rewritten if nothing changed the model in between
+    auto revision = m_revision;
+    QMetaObject::invokeMethod(this, [this, blockNumbers, revision]() {
+        if (m_revision != revision || blockNumbers.last() >= m_blocks.size())
+            return;
+
+        QVector<block> blocks;
+        blocks.reserve(blockNumbers.size());
+        for (auto blockNumber: blockNumbers)
+            blocks.append(m_blocks[blockNumber]);
+        applyBlocks(blockNumbers, blocks);
+    }, Qt::QueuedConnection);
 }
 
 void Editor::loadTranscriptData(QFile& file)
 {
     // qInfo()<<moveAlongTimeStamps; // Disabled debug
-    QXmlStreamReader reader(&file);
-    m_transcriptLang = "";
-    m_blocks.clear();
-    if (reader.readNextStartElement()) {
-        //Qt6
-        // if (reader.name() == "transcript") {
-        if (reader.name() == QString("transcript")) {
-            m_transcriptLang = reader.attributes().value("lang").toString();
-
-            while(reader.readNextStartElement()) {
-                //Qt6
-                // if(reader.name() == "line") {
-                if(reader.name() == QString("line")) {
-                    QString t1=reader.attributes().value("timestamp").toString();
-                    QStringList tl=t1.split(":");
-                    auto blockTimeStamp = getTime(reader.attributes().value("timestamp").toString());
-
-                    if(!blockTimeStamp.isValid()){
-                        QString t2="";
-                        if(t1.count(":")==1){
-                            int hr=tl[0].toInt()/60;
-                            if(hr<10){
-                                t2+="0";
-                                t2+=QString::number(hr);
-                            }
-                            else
-                                t2+=QString::number(hr);
-
-                            t2+=":";
-                            t2+=QString::number(tl[0].toInt()%60);
-                            t2+=":";
-                            t2+=tl[1];
-                            blockTimeStamp=getTime(t2);
-                        }
-                        else if(t1.count(":")==2){
-                            int hr=(tl[1].toInt()/60)+tl[0].toInt();
-
-                            if(hr<10){
-                                t2+="0";
-                                t2+=QString::number(hr);
-                            }
-                            else
-                                t2+=QString::number(hr);
-
-                            t2+=":";
-                            t2+=QString::number(tl[1].toInt()%60);
-                            t2+=":";
-                            t2+=tl[2];
-                            blockTimeStamp=getTime(t2);
-                        }
-                    }
-
-                    auto blockText = QString("");
-                    auto blockSpeaker = reader.attributes().value("speaker").toString();
-                    auto tagString = reader.attributes().value("tags").toString();
-                    QStringList tagList;
-                    if (tagString != "")
-                        tagList = tagString.split(",");
-
-                    struct block line = {blockTimeStamp, "", blockSpeaker, tagList, QVector<word>()};
-                    while(reader.readNextStartElement()){
-                        //Qt6
-                        // if(reader.name() == "word")
-                        if(reader.name() == QString("word")){
-                            QString isEditedStr = reader.attributes().value("isEdited").toString();
-                            auto wordTimeStamp  = getTime(reader.attributes().value("timestamp").toString());
-                            auto wordTagString  = reader.attributes().value("tags").toString();
-                            auto wordText       = reader.readElementText();
-                            QStringList wordTagList;
-                            if (wordTagString != "")
-                                wordTagList = wordTagString.split(",");
-
-                            blockText += (wordText + " ");
-                            line.words.append(makeWord(wordTimeStamp, wordText, wordTagList, isEditedStr.toLower()));
-                        }
-                        else
-                            reader.skipCurrentElement();
-                    }
-                    line.text = blockText.trimmed();
-                    m_blocks.append(line);
-                }
-                else
-                    reader.skipCurrentElement();
-            }
-        }
-        else
-            reader.raiseError(QObject::tr("Incorrect file"));
-    }
+    m_loadWatcher.cancel();
+    m_loading = false;
+    m_blockValidation.clear();
+    m_undoStack->clear();
+
+    TranscriptReader reader(&file);
+    m_transcriptLang = reader.language();
+    m_blocks = reader.readAll();
+    m_savedRevision = m_revision;
 }
 
-void Editor::saveXml(QFile* file)
+void Editor::saveTranscript(const QString& fileName)
 {
-    QXmlStreamWriter writer(file);
-    writer.setAutoFormatting(true);
-    writer.writeStartDocument();
-    writer.writeStartElement("transcript");
+    // One save is queued behind the running one, it snapshots the blocks
+    // when it starts and goes to the latest file name, e.g. after Save As
+    if (m_saving) {
+        m_queuedSave = fileName;
+        return;
+    }
+    m_saving = true;
 
-    if (m_transcriptLang != "")
-        writer.writeAttribute("lang", m_transcriptLang);
+    QElapsedTimer timer;
+    timer.start();
+    auto revision = m_revision;
 
-    //Qt6
-    // for (auto& a_block: qsConst(m_blocks)) {
-    for (auto& a_block: std::as_const(m_blocks)) {
-        if (a_block.text != "") {
-            // qDebug() << a_block.text; // Disabled debug
-            auto timeStamp = a_block.timeStamp;
-            QString timeStampString = timeStamp.toString("hh:mm:ss.zzz");
-            auto speaker = a_block.speaker;
-
-            writer.writeStartElement("line");
-            writer.writeAttribute("timestamp", timeStampString);
-            writer.writeAttribute("speaker", speaker);
-
-            if (!a_block.tagList.isEmpty())
-                writer.writeAttribute("tags", a_block.tagList.join(","));
-
-            for (auto& a_word: std::as_const(a_block.words)) {
-                writer.writeStartElement("word");
-                writer.writeAttribute("timestamp", a_word.timeStamp.toString("hh:mm:ss.zzz"));
-                writer.writeAttribute("isEdited", (a_word.isEdited == "true") ? "true": "false");
-
-                if (!a_word.tagList.isEmpty())
-                    writer.writeAttribute("tags", a_word.tagList.join(","));
-
-                writer.writeCharacters(a_word.text);
-                writer.writeEndElement();
-                // if(a_word.text.contains('.')==true)
-                // {
-                //     break;
-                // }
+    // m_blocks is implicitly shared, the worker writes a snapshot while editing goes on
+    QtConcurrent::run(&TranscriptWriter::save, fileName, m_transcriptLang, m_blocks)
+        .then(this, [this, fileName, revision, timer](QString errorString) {
+            m_saving = false;
+            if (!errorString.isEmpty()) {
+                qDebug() << "From saveTranscript - 1";
+                emit message(errorString);
             }
-            writer.writeEndElement();
-        }
-    }
-    writer.writeEndElement();
-    file->close();
-    delete file;
+            else {
+                m_savedRevision = revision;
+                emit message(QString("File Saved %1 (%2 ms)").arg(fileName).arg(timer.elapsed()));
+            }
+
+            if (!m_queuedSave.isEmpty())
+                saveTranscript(std::exchange(m_queuedSave, QString()));
+        });
 }
 
 void Editor::helpJumpToPlayer()
 {
     emit sendBlockText(textCursor().block().text());
-    auto currentBlockNumber = textCursor().blockNumber();
+    auto currentBlockNumber = cursorBlockNumber();
     auto timeToJump = QTime(0, 0);
 
-    if (m_blocks[currentBlockNumber].timeStamp.isNull())
+    if (!m_blocks[currentBlockNumber].hasTime())
         return;
 
     int positionInBlock = textCursor().positionInBlock();
@@ -1297,25 +1336,18 @@ void Editor::helpJumpToPlayer()
     if (m_blocks[currentBlockNumber].speaker != "" || textCursor().block().text().contains("{}:"))
         wordNumber--;
 
-    for (int i = currentBlockNumber - 1; i >= 0; i--) {
-        if (m_blocks[i].timeStamp.isValid()) {
-
-            timeToJump = m_blocks[i].timeStamp;
-            break;
-        }
-    }
+    if (m_timeIndex.previousBlockTime(currentBlockNumber).isValid())
+        timeToJump = m_timeIndex.previousBlockTime(currentBlockNumber);
 
     // If we can jump to a word, then do so
     if (wordNumber >= 0 &&
-        wordNumber < m_blocks[currentBlockNumber].words.size() &&
-        m_blocks[currentBlockNumber].words[wordNumber].timeStamp.isValid()
+        wordNumber < m_blocks[currentBlockNumber].wordCount() &&
+        m_blocks[currentBlockNumber].wordHasTime(wordNumber)
         ) {
-        for (int i = wordNumber - 1; i >= 0; i--) {
-            if (m_blocks[currentBlockNumber].words[i].timeStamp.isValid()) {
-                timeToJump = m_blocks[currentBlockNumber].words[i].timeStamp;
-                emit jumpToPlayer(timeToJump);
-                return;
-            }
+        auto previousWordTime = m_timeIndex.previousWordTime(currentBlockNumber, wordNumber);
+        if (previousWordTime.isValid()) {
+            emit jumpToPlayer(previousWordTime);
+            return;
         }
     }
     // qInfo()<<timeToJump; // Disabled debug
@@ -1324,98 +1356,62 @@ void Editor::helpJumpToPlayer()
 
 void Editor::loadDictionary()
 {
-    m_correctedWords.clear();
-    m_dictionary.clear();
-    if(QFile::exists("Dictonaries/"+m_transcriptLang+"/"+m_transcriptLang+"combined.txt")){
-        auto dictionaryFileName = "Dictonaries/"+m_transcriptLang+"/"+m_transcriptLang+"combined.txt";
-        m_dictionary = listFromFile(dictionaryFileName);
-        //        qInfo()<<m_dictionary;
+    // Words corrected in earlier sessions are merged into the dictionary
+    // itself, the ones of this session are kept next to it
+    auto& dictionaryService = DictionaryService::getInstance();
+    m_completionModel->setCorrectedWords(dictionaryService.correctedWords(m_transcriptLang));
 
+    // The language is held while the editor uses it, so it isn't evicted
+    if (m_heldLanguage != m_transcriptLang) {
+        dictionaryService.acquire(m_transcriptLang);
+        if (!m_heldLanguage.isEmpty())
+            dictionaryService.release(m_heldLanguage);
+        m_heldLanguage = m_transcriptLang;
     }
-    else{
-        auto dictionaryFileName = QString(":/wordlists/%1.txt").arg(m_transcriptLang);
-        m_dictionary = listFromFile(dictionaryFileName);
-    }
-    if(!m_customDictonaryPath.isNull()){
-        auto customdictionaryFileName = QString(m_customDictonaryPath);
-        auto wordsFromCustomDictonary=listFromFile(customdictionaryFileName);
-        for (auto& word : wordsFromCustomDictonary) {
-            word = word.toLower();
-        }
 
-        auto combined_dictionary=m_dictionary;
-        combined_dictionary.append(wordsFromCustomDictonary);
-        combined_dictionary.sort();
-        QDir dictonaryFolder("Dictonaries");
-        if(!dictonaryFolder.exists()){
-            dictonaryFolder.mkpath(".");
-        }
-        QDir languageFolder("Dictonaries/"+m_transcriptLang);
-        if(!languageFolder.exists()){
-            languageFolder.mkpath(".");
-        }
-        QDir dir("Dictonaries/"+m_transcriptLang+"/"+m_transcriptLang+"combined.txt");
+    // The dictionary arrives through dictionaryReady(), right away if it is cached
+    dictionaryService.load(m_transcriptLang);
+}
 
-        QFile file2(dir.absolutePath());
-        if(!file2.open(QIODevice::OpenModeFlag::WriteOnly|QIODevice::Truncate)){
-            qDebug() << "From Dictionary - 1";
-            QMessageBox::critical(this,"Error",file2.errorString());
-            return;
-        }
-        QString a=dir.absolutePath();
-        QString x("");
-        for(auto i: combined_dictionary){
-            x.append(i+"\n");
-        }
-        file2.write(QByteArray(x.toUtf8()));
-        file2.flush();
-        file2.close();
-        auto combinedCustomdictionaryFileName = QString(a);
-        m_dictionary=listFromFile(combinedCustomdictionaryFileName);
-        //         qInfo()<<a<<'\n';
-    }
-    // if (m_transcriptLang == "hindi")
-    //     qInfo()<<m_dictionary<<'\n';
-    auto correctedWordsList = listFromFile(QString("corrected_words_%1.txt").arg(m_transcriptLang));
-    if (!correctedWordsList.isEmpty()) {
-        std::copy(correctedWordsList.begin(),
-                  correctedWordsList.end(),
-                  std::inserter(m_correctedWords, m_correctedWords.begin()));
-
-        for (auto& a_word: m_correctedWords) {
-            m_dictionary.insert
-                (
-                    std::upper_bound(m_dictionary.begin(), m_dictionary.end(), a_word),
-                    a_word
-                    );
-        }
+void Editor::dictionaryReady(const QString& language, const WordList& words)
+{
+    if (language == m_customDictionaryLanguage && !m_customDictionaryWords.isEmpty())
+        mergeCustomDictionary(language, words);
+
+    bool dictionaryChanged = false;
+
+    if (language == "english" && !m_english_dictionary.isSharedWith(words)) {
+        m_english_dictionary = words;
+        dictionaryChanged = m_transcriptLang != "english";
+    }
+    if (language == m_transcriptLang && !m_dictionary.isSharedWith(words)) {
+        m_dictionary = words;
+        m_completionModel->setDictionary(m_dictionary);
+        dictionaryChanged = true;
     }
-    m_english_dictionary.sort();
-    m_dictionary.sort();
-    m_textCompleter->setModel(new QStringListModel(m_dictionary, m_textCompleter));
 
-    if (!m_highlighter)
+    if (!dictionaryChanged || !m_highlighter)
         return;
 
-    QMultiMap<int, int> invalidWords;
-    for (int i = 0; i < m_blocks.size(); i++) {
+    startValidation();
+}
 
-        for (int j = 0; j < m_blocks[i].words.size(); j++) {
-            auto wordText = m_blocks[i].words[j].text.toLower();
+void Editor::correctedWordAdded(const QString& language, const QString& word)
+{
+    if (language != m_transcriptLang)
+        return;
 
-            if (wordText != "" && m_punctuation.contains(wordText.back()))
-                wordText = wordText.left(wordText.size() - 1);
+    m_completionModel->setCorrectedWords(DictionaryService::getInstance().correctedWords(language));
 
-            if (!isWordValid(wordText,
-                             m_dictionary,
-                             m_english_dictionary,
-                             m_transcriptLang)) {
-                invalidWords.insert(i, j);
-            }
-        }
+    // Only the blocks holding the word can change
+    int lastRevalidated = -1;
+    for (auto& position: m_wordIndex.occurrences(word)) {
+        if (position.block == lastRevalidated)
+            continue;
+        lastRevalidated = position.block;
+        revalidateBlocks(position.block, position.block);
+        applyValidation(position.block, position.block);
     }
-    m_highlighter->setInvalidWords(invalidWords);
-    m_highlighter->rehighlight();
 }
 
 QStringList Editor::listFromFile(const QString& fileName)
@@ -1449,9 +1445,7 @@ void Editor::setShowTimeStamp()
     settings->setValue("showTimeStamps", QVariant(showTimeStamp).toString());
     // SettingsManager::getInstance().setShowTimeStamps(showTimeStamp);
 
-    setContent();
-    QTextCursor cursorx(this->document()->findBlockByNumber(highlightedBlock));
-    this->setTextCursor(cursorx);
+    setTimeStampAreaVisible(showTimeStamp);
 
 }
 
@@ -1460,166 +1454,58 @@ void Editor::setContent()
     if (!settingContent) {
         settingContent = true;
 
-        if (m_highlighter)
-            delete m_highlighter;
-
-        QString content_with_time_stamp("");
-        QString content_without_time_stamp("");
-        for (auto& a_block: std::as_const(m_blocks)) {
-            auto blockText = "{" + a_block.speaker + "}: " + a_block.text + " {" + a_block.timeStamp.toString("hh:mm:ss.zzz") + "}";
-            content_with_time_stamp.append(blockText + "\n");
-        }
-
-        for (auto& a_block: std::as_const(m_blocks)) {
-            auto blockText = "{" + a_block.speaker + "}: " + a_block.text ;
-            content_without_time_stamp.append(blockText + "\n");
-        }
-
-        if(showTimeStamp){
-            setPlainText(content_with_time_stamp.trimmed());}
-        else{
-            setPlainText(content_without_time_stamp.trimmed());
-        }
-        m_highlighter = new Highlighter(document());
-
-        QList<int> invalidBlocks;
-        QList<int> taggedBlocks;
-        QMultiMap<int, int> invalidWords;
-        QMultiMap<int, int>  taggedWords;
-        QMultiMap<int, int> editedWords;
-        for (int i = 0; i < m_blocks.size(); i++) {
-            if (m_blocks[i].timeStamp.isNull())
-                invalidBlocks.append(i);
-            else if(!m_blocks[i].tagList.isEmpty()){
-                taggedBlocks.append(i);
-            }
-            else {
-
-                for (int j = 0; j < m_blocks[i].words.size(); j++) {
-                    auto wordText = m_blocks[i].words[j].text.toLower();
-                    // auto isWordEdited = m_blocks[i].words[j].isEdited;
-
-                    // if (isWordEdited == "true") {
-                    //     editedWords.insert(i, j);
-                    // }
-
-                    if (wordText != "" && m_punctuation.contains(wordText.back()))
-                        wordText = wordText.left(wordText.size() - 1);
-
-                    if (wordText != "" && wordText[0] == '\"'){
-
-                        QString text="";
-                        for(int i=1;i<wordText.size();i++){
-                            text+=wordText[i];
-                        }
-                        wordText=text;
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == '\"'){
-                        wordText = wordText.left(wordText.size() - 1);
-
-                    }
-                    if (wordText != "" && wordText[0] == '('){
-
-                        QString text="";
-                        for(int i=1;i<wordText.size();i++){
-                            text+=wordText[i];
-                        }
-                        wordText=text;
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == ')'){
-                        wordText = wordText.left(wordText.size() - 1);
-
-                    }
-                    if (wordText != "" && wordText[0] == '['){
-
-                        QString text="";
-                        for(int i=1;i<wordText.size();i++){
-                            text+=wordText[i];
-                        }
-                        wordText=text;
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == ']'){
-                        wordText = wordText.left(wordText.size() - 1);
-                        // qInfo()<<wordText; // Disabled debug
-                    }
-                    if (wordText != "" && wordText[0] == '{'){
-                        QString text="";
-                        for(int i=1;i<wordText.size();i++){
-                            text+=wordText[i];
-                        }
-                        wordText=text;
-                    }
-                    if (wordText != "" &&wordText[wordText.size()-1] == '}'){
-                        wordText = wordText.left(wordText.size() - 1);
-
-                    }
-                    if (wordText != "" && wordText[0] == '\''){
-
-                        QString text="";
-                        for(int i=1;i<wordText.size();i++){
-                            text+=wordText[i];
-                        }
-                        wordText=text;
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == '\''){
-                        wordText = wordText.left(wordText.size() - 1);
-
-                    }
-                    if (wordText != "" && wordText[0] == '<'){
-
-                        QString text="";
-                        for(int i=1;i<wordText.size();i++){
-                            text+=wordText[i];
-                        }
-                        wordText=text;
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == '>'){
-                        wordText = wordText.left(wordText.size() - 1);
-
-                    }
+        m_blockValidation.resize(m_blocks.size());
+
+        // Only the first blocks go in the document, like setPlainText the
+        // view starts at the top and the rest is paged in as it moves
+        m_windowFirst = 0;
+        m_windowCount = qMin(int(m_blocks.size()), 2 * windowMargin);
+        m_parkedBlock = -1;
+        setPlainText(windowText(0, m_windowCount));
+        updateHighlightWindow();
+        rebuildIndexes();
+        m_timeIndex.update(m_blocks);
+
+        // setPlainText drops the block user data, so the cached flags are
+        // attached to the new blocks until the background validation replaces them.
+        applyValidation();
+        startValidation();
+        updatePlaybackHighlight();
+        highlightOccurrences();
+        updateLineNumbers();
+        updateBlockScrollBar();
+        settingContent = false;
+    }
+}
 
-                    if (wordText != "" && wordText[wordText.size()-1] == '?'){
-                        wordText = wordText.left(wordText.size() - 1);
+QString Editor::blockTimeStamp(int blockNumber) const
+{
+    if (blockNumber < 0 || blockNumber >= m_blocks.size())
+        return {};
+    return TimeCodec::toString(m_blocks[blockNumber].time);
+}
 
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == '!'){
-                        wordText = wordText.left(wordText.size() - 1);
+void Editor::editTimeStamp(int blockNumber)
+{
+    if (blockNumber < 0 || blockNumber >= m_blocks.size())
+        return;
 
-                    }
-                    if (wordText != "" && wordText[wordText.size()-1] == ','){
-                        wordText = wordText.left(wordText.size() - 1);
+    bool accepted = false;
+    auto text = QInputDialog::getText(this, "Edit Time Stamp", "Time Stamp (hh:mm:ss.zzz):", QLineEdit::Normal,
+                                      TimeCodec::toString(m_blocks[blockNumber].time), &accepted);
+    if (!accepted)
+        return;
 
-                    }
-                    static QRegularExpression regex("([0-1][0-9]|2[0-3]):([0-5][0-9]):([0-5][0-9])(\\.[0-9]+)?");
-                    bool match = regex.match(wordText).hasMatch();
-                    if (match) {
-                        continue;
-                        // the string is a valid time in the format "HH:MM:SS.f"
-                    }
-                    if (!isWordValid(wordText,
-                                     m_dictionary,
-                                     m_english_dictionary,
-                                     m_transcriptLang)) {
-                        invalidWords.insert(i, j);
-                    }
-                    if(!m_blocks[i].words[j].tagList.empty()){
-                        taggedWords.insert(i,j);
-                    }
-                    if(m_blocks[i].words[j].isEdited == "true") {
-                        editedWords.insert(i, j);
-                    }
-                }
-            }
-        }
-        m_highlighter->setInvalidBlocks(invalidBlocks);
-        m_highlighter->setTaggedBlocks(taggedBlocks);
-        m_highlighter->setInvalidWords(invalidWords);
-        m_highlighter->setTaggedWords(taggedWords);
-        m_highlighter->setBlockToHighlight(highlightedBlock);
-        m_highlighter->setWordToHighlight(highlightedWord);
-        m_highlighter->setEditedWords(editedWords);
-        settingContent = false;
+    auto time = TimeCodec::parseMilliseconds(text.trimmed());
+    if (time == TranscriptTime::noTime) {
+        QMessageBox errorBox(QMessageBox::Critical, "Error", "Invalid Time Stamp", QMessageBox::Ok);
+        errorBox.exec();
+        return;
     }
+
+    auto stampedBlock = m_blocks[blockNumber];
+    stampedBlock.time = time;
+    replaceBlocks(blockNumber, 1, {stampedBlock});
 }
 
 bool Editor::timestampVisibility()
@@ -1634,405 +1520,753 @@ void Editor::contentChanged(int position, int charsRemoved, int charsAdded)
         return;
 
     if (m_blocks.isEmpty()) { // If block data is empty (i.e. no file opened) just fill them from editor
-        for (int i = 0; i < document()->blockCount(); i++)
-            m_blocks.append(fromEditor(i));
+        QVector<int> stampedBlocks;
+        for (int i = 0; i < document()->blockCount(); i++) {
+            m_blocks.append(fromEditor(i, m_pasting));
+            if (m_blocks.last().hasTime())
+                stampedBlocks.append(i);
+        }
+        m_revision++;
+        m_windowFirst = 0;
+        m_windowCount = m_blocks.size();
+        m_parkedBlock = -1;
+        rebuildIndexes();
+        m_timeIndex.update(m_blocks);
+        startValidation();
+        updateBlockScrollBar();
+        stripPastedTimeStamps(stampedBlocks);
         return;
     }
 
-    delete m_highlighter;
-    m_highlighter = new Highlighter(this->document());
+    // The changed range covers whole lines, the model only reconciles those.
+    // Lines are counted in the document, which holds the blocks from
+    // m_windowFirst on.
+    int newCount = 0, oldCount = 0;
+    int firstLine = document()->findBlock(position).blockNumber();
+    auto lastTextBlock = document()->findBlock(position + charsAdded);
+    int lastLine = lastTextBlock.isValid() ? lastTextBlock.blockNumber() : blockCount() - 1;
+    if (firstLine >= 0 && lastLine >= firstLine) {
+        newCount = lastLine - firstLine + 1;
+        oldCount = newCount - (blockCount() - m_windowCount);
+    }
+    if (firstLine < 0 || oldCount < 1 || firstLine + oldCount > m_windowCount) {
+        firstLine = 0;
+        newCount = blockCount();
+        oldCount = m_windowCount;
+    }
 
-    int currentBlockNumber = textCursor().blockNumber();
+    // Lines still reading as their block are left alone, which also drops
+    // the format-only changes reported while highlighting
+    auto isUnchanged = [&](int oldLine, int newLine) {
+        return lineMatchesBlock(document()->findBlockByNumber(newLine).text(), m_blocks[m_windowFirst + oldLine]);
+    };
+    while (oldCount && newCount && isUnchanged(firstLine, firstLine)) {
+        firstLine++;
+        oldCount--;
+        newCount--;
+    }
+    while (oldCount && newCount && isUnchanged(firstLine + oldCount - 1, firstLine + newCount - 1)) {
+        oldCount--;
+        newCount--;
+    }
+    if (!oldCount && !newCount)
+        return;
+    int firstBlock = m_windowFirst + firstLine;
+
+    // The first and last edited lines keep the word times and tags of the
+    // blocks they were edited from, the lines in between are new. Pasted
+    // lines may end with the timestamp of an export, which replaces theirs.
+    QVector<int> stampedBlocks;
+    QVector<block> editedBlocks;
+    editedBlocks.reserve(newCount);
+    for (int i = 0; i < newCount; i++) {
+        auto blockFromEditor = fromEditor(firstLine + i, m_pasting);
+        if (i == 0 && oldCount)
+            editedBlocks.append(mergeEditedBlock(m_blocks[firstBlock], blockFromEditor));
+        else if (i == newCount - 1 && oldCount > 1)
+            editedBlocks.append(mergeEditedBlock(m_blocks[firstBlock + oldCount - 1], blockFromEditor));
+        else
+            editedBlocks.append(blockFromEditor);
 
-    if(m_blocks.size() != blockCount()) {
-        auto blocksChanged = m_blocks.size() - blockCount();
-        if (blocksChanged > 0) { // Blocks deleted
-            // qInfo() << "[Lines Deleted]" << QString("%1 lines deleted").arg(QString::number(blocksChanged)); // Disabled debug
-            for (int i = 1; i <= blocksChanged; i++)
-                m_blocks.removeAt(currentBlockNumber + 1);
-        }
-        else { // Blocks added
-            // qInfo() << "[Lines Inserted]" << QString("%1 lines inserted").arg(QString::number(-blocksChanged)); // Disabled debug
-            for (int i = 1; i <= -blocksChanged; i++) {
-                if (document()->findBlockByNumber(currentBlockNumber + blocksChanged).text().trimmed() == "")
-                    m_blocks.insert(currentBlockNumber + blocksChanged, fromEditor(currentBlockNumber - i));
-                else
-                    m_blocks.insert(currentBlockNumber + blocksChanged + 1, fromEditor(currentBlockNumber - i + 1));
-            }
+        if (blockFromEditor.hasTime()) {
+            editedBlocks.last().time = blockFromEditor.time;
+            stampedBlocks.append(firstBlock + i);
         }
     }
 
-    auto currentBlockFromEditor = fromEditor(currentBlockNumber);
-    auto& currentBlockFromData = m_blocks[currentBlockNumber];
-
-    if (currentBlockFromData.speaker != currentBlockFromEditor.speaker) {
-        // qInfo() << "[Speaker Changed]"
-        //         << QString("line number: %1").arg(QString::number(currentBlockNumber + 1))
-        //         << QString("initial: %1").arg(currentBlockFromData.speaker)
-        //         << QString("final: %1").arg(currentBlockFromEditor.speaker); // Disabled debug
+    // Nothing to record when the lines read back as the blocks they were
+    auto oldBlocks = m_blocks.mid(firstBlock, oldCount);
+    if (editedBlocks == oldBlocks)
+        return;
+    spliceBlocks(firstBlock, oldCount, editedBlocks);
+    m_windowCount += newCount - oldCount;
+    if (newCount)
+        applyValidation(firstBlock, firstBlock + newCount - 1);
+    // Typed into a single line, it may continue the last undo step
+    TypedEdit typedEdit;
+    if (oldCount == 1 && newCount == 1 && !m_pasting) {
+        typedEdit.position = position - document()->findBlockByNumber(firstLine).position();
+        typedEdit.charsRemoved = charsRemoved;
+        typedEdit.charsAdded = charsAdded;
+        typedEdit.addedSpace = charsAdded > 0;
+        for (int i = position; i < position + charsAdded && typedEdit.addedSpace; i++)
+            typedEdit.addedSpace = document()->characterAt(i).isSpace();
+        typedEdit.time = QDateTime::currentMSecsSinceEpoch();
+    }
+    m_undoStack->push(new BlockEditCommand(this, firstBlock, oldBlocks, editedBlocks, true, typedEdit));
+    stripPastedTimeStamps(stampedBlocks);
+    if (newCount != oldCount)
+        updateBlockScrollBar();
 
-        currentBlockFromData.speaker = currentBlockFromEditor.speaker;
+    updateWordEditor();
+    if(realTimeDataSaver){
+        transcriptSave();
     }
-    if(showTimeStamp){
-        if (currentBlockFromData.timeStamp != currentBlockFromEditor.timeStamp) {
 
-            currentBlockFromData.timeStamp = currentBlockFromEditor.timeStamp;
-            // qInfo() << "[TimeStamp Changed]"
-            //         << QString("line number: %1, %2").arg(QString::number(currentBlockNumber + 1), currentBlockFromEditor.timeStamp.toString("hh:mm:ss.zzz"));
+    // {
+    //     QMutexLocker locker(&queueMutex);
+    //     taskQueue.enqueue({
+    //         QVariant(position),
+    //         QVariant(charsRemoved),
+    //         QVariant(charsAdded),
+    //         QVariant(textCursor().blockNumber()),
+    //         QVariant(document()->blockCount()),
+    //         QVariant::fromValue(currentBlockFromEditor),
+    //         QVariant::fromValue(currentBlockFromData)
+    //     });
+    // }
 
-        }
-    }
-    if (currentBlockFromData.text != currentBlockFromEditor.text) {
-        // qInfo() << "[Text Changed]"
-        //         << QString("line number: %1").arg(QString::number(currentBlockNumber + 1))
-        //         << QString("initial: %1").arg(currentBlockFromData.text)
-        //         << QString("final: %1").arg(currentBlockFromEditor.text); // Disabled debug
+    // std::cerr << "Enqueued task\n";
 
-        currentBlockFromData.text = currentBlockFromEditor.text;
-        auto tagList = currentBlockFromData.tagList;
+    // QMetaObject::invokeMethod(this, "processNextTask", Qt::QueuedConnection);
 
-        auto& wordsFromEditor = currentBlockFromEditor.words;
-        auto& wordsFromData = currentBlockFromData.words;
+    // debounceTimer->start();
+    // handleContentChanged();
 
-        int wordsDifference = wordsFromEditor.size() - wordsFromData.size();
-        int diffStart{-1}, diffEnd{-1};
+}
 
-        bool flag = true;
-        for (int i = 0; i < wordsFromEditor.size() && i < wordsFromData.size(); i++)
-            if (flag && wordsFromEditor[i].text != wordsFromData[i].text) {
-                diffStart = i;
-                flag = false;
-                // break; //added flag instead of breaking
-            } else {
-                wordsFromEditor[i].isEdited = wordsFromData[i].isEdited;
-            }
+// void Editor::processNextTask() {
 
-        if (diffStart == -1)
-            diffStart = wordsFromEditor.size() - 1;
-        for (int i = 0; i <= diffStart; i++)
-            if (i < wordsFromData.size()){
-                wordsFromEditor[i].timeStamp = wordsFromData[i].timeStamp;
-                //                wordsFromEditor[i].tagList = wordsFromData[i].tagList;
-            }
+//     std::cerr << "Processing next task\n";
 
-        if (!wordsDifference) {
-            wordsFromEditor[diffStart].isEdited = "true";
-            for (int i = diffStart; i < wordsFromEditor.size(); i++){
-                wordsFromEditor[i].timeStamp = wordsFromData[i].timeStamp;
-                wordsFromEditor[i].tagList = wordsFromData[i].tagList;
-            }
-        }
+//     if (taskQueue.isEmpty())
+//         return;
 
-        if (wordsDifference > 0) {
-            // qInfo()<<"exceeds";  // Disabled debug
+//     if (!taskSemaphore.tryAcquire()) {
+//         return;
+//     }
 
-            int counter = 0;
-            for (int i = 0, j = 0; i < wordsFromData.size() && j < wordsFromEditor.size();) {
-                if (wordsFromData[i].text != wordsFromEditor[j].text && counter < 2) {
+//     QVariantList task;
+//     {
+//         QMutexLocker locker(&queueMutex);
+//         if (taskQueue.isEmpty()) {  // Check again under lock
+//             taskSemaphore.release();
+//             return;
+//         }
+//         task = taskQueue.dequeue();
+//     }
 
-                    wordsFromEditor[j].isEdited = "true";
-                    counter++;
-                    if (counter == 2)
-                        i++;
-                    j++;
-                } else {
+//     int position = task[0].toInt();
+//     int charsRemoved = task[1].toInt();
+//     int charsAdded = task[2].toInt();
+//     int currentBlockNumber = task[3].toInt();
+//     int blockCount = task[4].toInt();
+//     block currentBlockFromEditor = task[5].value<block>();
+//     block currentBlockFromData = task[6].value<block>();
 
-                    wordsFromEditor[j].isEdited = wordsFromData[i].isEdited;
-                    i++;
-                    j++;
+//     auto* worker = new TaskRunner(
+//         this,
+//         task[0].toInt(),
+//         task[1].toInt(),
+//         task[2].toInt(),
+//         task[3].toInt(),
+//         task[4].toInt(),
+//         task[5].value<block>(),
+//         task[6].value<block>()
+//         );
 
-                }
-            }
-            for (int i = wordsFromEditor.size() - 1, j = wordsFromData.size() - 1; j > diffStart; i--, j--) {
-                if (wordsFromEditor[i].text == wordsFromData[j].text){
-                    wordsFromEditor[i].timeStamp = wordsFromData[j].timeStamp;
-                    //                    wordsFromEditor[i].tagList = wordsFromData[j].tagList;
-                }
-            }
+//     std::cerr << "Starting worker\n";
+//     QThreadPool::globalInstance()->start(worker);
+// }
 
-            for (int i=wordsFromData.size()-1;i>=0;i--){
-                if(!wordsFromData[i].tagList.empty()){
-                    for (int j=wordsFromEditor.size()-1;j>=0;j--){
-                        if (wordsFromEditor[j].text == wordsFromData[i].text){
-                            if(wordsFromEditor[j].tagList.empty())
-                                wordsFromEditor[j].tagList = wordsFromData[i].tagList;
-                        }
-                    }
-                }
-            }
-        }
-        else if (wordsDifference < 0) {
-            for (int i = wordsFromEditor.size() - 1, j = wordsFromData.size() - 1; i > diffStart; i--, j--)
-                if (wordsFromEditor[i].text == wordsFromData[j].text){
-                    wordsFromEditor[i].timeStamp = wordsFromData[j].timeStamp;
-                    //                    wordsFromEditor[i].tagList = wordsFromData[j].tagList;
-                }
-            for (int i=wordsFromData.size()-1;i>=0;i--){
-                if(!wordsFromData[i].tagList.empty()){
-                    for (int j=wordsFromEditor.size()-1;j>=0;j--){
-                        if (wordsFromEditor[j].text == wordsFromData[i].text){
-                            if(wordsFromEditor[j].tagList.empty())
-                                wordsFromEditor[j].tagList = wordsFromData[i].tagList;
-                        }
-                    }
-                }
-            }
-        }
+// void Editor::processContentChange(int position, int charsRemoved, int charsAdded, int currentBlockNumber, int blockCount,
+//                                   block currentBlockFromEditor, block currentBlockFromData) {
 
-        //currentBlockFromData = currentBlockFromEditor;
-        if(showTimeStamp)
-            currentBlockFromData = currentBlockFromEditor;
-        else{
-            currentBlockFromData.speaker = currentBlockFromEditor.speaker;
-            currentBlockFromData.text = currentBlockFromEditor.text;
-            currentBlockFromData.words = currentBlockFromEditor.words;
-            currentBlockFromData.tagList = currentBlockFromEditor.tagList;
-        }
+//     std::cerr << "Processing content change\n";
+//     QMutexLocker locker(&queueMutex);
+//     std::cerr << "After locker\n";
 
-        currentBlockFromData.tagList = tagList;
-    }
 
-    m_highlighter->setBlockToHighlight(highlightedBlock);
-    m_highlighter->setWordToHighlight(highlightedWord);
+//     std::cerr << "Task completed\n";
+// }
 
-    QList<int> invalidBlocks;
-    QList<int> taggedBlocks;
-    QMultiMap<int, int> invalidWords;
-    QMultiMap<int, int>  taggedWords;
-    QMultiMap<int, int> editedWords;
+// void Editor::handleContentChanged() {
 
-    for (int i = 0; i < m_blocks.size(); i++) {
-        if (m_blocks[i].timeStamp.isNull())
-            invalidBlocks.append(i);
-        else if(!m_blocks[i].tagList.isEmpty()){
-            taggedBlocks.append(i);
+
+
+// }
+
+block Editor::mergeEditedBlock(const block& blockFromData, block blockFromEditor) const
+{
+    // The timestamp and the block tags aren't part of the line, they are kept from the data
+    auto mergedBlock = blockFromData;
+    mergedBlock.speaker = blockFromEditor.speaker;
+    if (blockFromData.text() == blockFromEditor.text())
+        return mergedBlock;
+
+    if (!blockFromEditor.wordCount()) {
+        mergedBlock.setWords({});
+        return mergedBlock;
+    }
+
+    // The words are matched up as separate values, then joined into the line again
+    auto wordsFromEditor = blockFromEditor.words();
+    auto wordsFromData = blockFromData.words();
+
+    int wordsDifference = wordsFromEditor.size() - wordsFromData.size();
+    int diffStart{-1}, diffEnd{-1};
+
+    bool flag = true;
+    for (int i = 0; i < wordsFromEditor.size() && i < wordsFromData.size(); i++)
+        if (flag && wordsFromEditor[i].text != wordsFromData[i].text) {
+            diffStart = i;
+            flag = false;
+            // break; //added flag instead of breaking
+        } else {
+            wordsFromEditor[i].isEdited = wordsFromData[i].isEdited;
         }
-        else {
-            for (int j = 0; j < m_blocks[i].words.size(); j++) {
-                auto wordText = m_blocks[i].words[j].text.toLower();
-                auto isWordEdited = m_blocks[i].words[j].isEdited == "true";
 
-                if (isWordEdited) {
-                    editedWords.insert(i, j);
-                }
-                if (wordText != "" && m_punctuation.contains(wordText.back()))
-                    wordText = wordText.left(wordText.size() - 1);
+    if (diffStart == -1)
+        diffStart = wordsFromEditor.size() - 1;
+    for (int i = 0; i <= diffStart; i++)
+        if (i < wordsFromData.size()){
+            wordsFromEditor[i].time = wordsFromData[i].time;
+            //                wordsFromEditor[i].tagList = wordsFromData[i].tagList;
+        }
 
-                if (wordText != "" && wordText[0] == '\"'){
+    if (!wordsDifference) {
+        wordsFromEditor[diffStart].isEdited = true;
+        for (int i = diffStart; i < wordsFromEditor.size(); i++){
+            wordsFromEditor[i].time = wordsFromData[i].time;
+            wordsFromEditor[i].tagList = wordsFromData[i].tagList;
+        }
+    }
 
-                    QString text="";
-                    for(int i=1;i<wordText.size();i++){
-                        text+=wordText[i];
-                    }
-                    wordText=text;
-                }
-                if (wordText != "" && wordText[wordText.size()-1] == '\"'){
-                    wordText = wordText.left(wordText.size() - 1);
+    if (wordsDifference > 0) {
+        // qInfo()<<"exceeds";  // Disabled debug
 
-                }
-                if (wordText != "" && wordText[0] == '('){
+        int counter = 0;
+        for (int i = 0, j = 0; i < wordsFromData.size() && j < wordsFromEditor.size();) {
+            if (wordsFromData[i].text != wordsFromEditor[j].text && counter < 2) {
 
-                    QString text="";
-                    for(int i=1;i<wordText.size();i++){
-                        text+=wordText[i];
-                    }
-                    // qInfo()<<text;  // Disabled debug
-                    wordText=text;
-                }
-                if (wordText != "" && wordText[wordText.size()-1] == ')'){
-                    wordText = wordText.left(wordText.size() - 1);
+                wordsFromEditor[j].isEdited = true;
+                counter++;
+                if (counter == 2)
+                    i++;
+                j++;
+            } else {
 
-                }
-                if (wordText != "" && wordText[0] == '['){
+                wordsFromEditor[j].isEdited = wordsFromData[i].isEdited;
+                i++;
+                j++;
 
-                    QString text="";
-                    for(int i=1;i<wordText.size();i++){
-                        text+=wordText[i];
-                    }
-                    wordText=text;
-                }
-                if (wordText != "" && wordText[wordText.size()-1] == ']'){
-                    wordText = wordText.left(wordText.size() - 1);
+            }
+        }
+        for (int i = wordsFromEditor.size() - 1, j = wordsFromData.size() - 1; j > diffStart; i--, j--) {
+            if (wordsFromEditor[i].text == wordsFromData[j].text){
+                wordsFromEditor[i].time = wordsFromData[j].time;
+                //                    wordsFromEditor[i].tagList = wordsFromData[j].tagList;
+            }
+        }
 
-                }
-                if (wordText != "" && wordText[0] == '{'){
-                    QString text="";
-                    for(int i=1;i<wordText.size();i++){
-                        text+=wordText[i];
+        for (int i=wordsFromData.size()-1;i>=0;i--){
+            if(!wordsFromData[i].tagList.empty()){
+                for (int j=wordsFromEditor.size()-1;j>=0;j--){
+                    if (wordsFromEditor[j].text == wordsFromData[i].text){
+                        if(wordsFromEditor[j].tagList.empty())
+                            wordsFromEditor[j].tagList = wordsFromData[i].tagList;
                     }
-                    wordText=text;
                 }
-                if (wordText != "" &&wordText[wordText.size()-1]== '}'){
-                    wordText = wordText.left(wordText.size() - 1);
-
-                }
-                if (wordText != "" && wordText[0] == '\''){
-
-                    QString text="";
-                    for(int i=1;i<wordText.size();i++){
-                        text+=wordText[i];
+            }
+        }
+    }
+    else if (wordsDifference < 0) {
+        for (int i = wordsFromEditor.size() - 1, j = wordsFromData.size() - 1; i > diffStart; i--, j--)
+            if (wordsFromEditor[i].text == wordsFromData[j].text){
+                wordsFromEditor[i].time = wordsFromData[j].time;
+                //                    wordsFromEditor[i].tagList = wordsFromData[j].tagList;
+            }
+        for (int i=wordsFromData.size()-1;i>=0;i--){
+            if(!wordsFromData[i].tagList.empty()){
+                for (int j=wordsFromEditor.size()-1;j>=0;j--){
+                    if (wordsFromEditor[j].text == wordsFromData[i].text){
+                        if(wordsFromEditor[j].tagList.empty())
+                            wordsFromEditor[j].tagList = wordsFromData[i].tagList;
                     }
-                    wordText=text;
                 }
-                if (wordText != "" && wordText[wordText.size()-1] == '\''){
-                    wordText = wordText.left(wordText.size() - 1);
+            }
+        }
+    }
 
-                }
-                if (wordText != "" && wordText[0] == '<'){
+    mergedBlock.setWords(wordsFromEditor);
+    return mergedBlock;
+}
 
-                    QString text="";
-                    for(int i=1;i<wordText.size();i++){
-                        text+=wordText[i];
-                    }
-                    wordText=text;
-                }
-                if (wordText != "" && wordText[wordText.size()-1] == '>'){
-                    wordText = wordText.left(wordText.size() - 1);
+int Editor::replaceAll(const QRegularExpression& expression, const QString& replacement, bool expandGroups)
+{
+    if (!expression.isValid() || m_blocks.isEmpty())
+        return 0;
 
-                }
+    int replacementCount = 0;
+    QVector<int> replacedBlockNumbers;
+    QVector<block> replacedBlocks;
+    for (int i = 0; i < m_blocks.size(); i++) {
+        int blockReplacements = 0;
+        auto replacedBlock = replaceInBlock(m_blocks[i], expression, replacement, expandGroups, blockReplacements);
+        if (!blockReplacements)
+            continue;
+        replacementCount += blockReplacements;
+        replacedBlockNumbers.append(i);
+        replacedBlocks.append(replacedBlock);
+    }
+    if (replacedBlocks.isEmpty())
+        return 0;
+
+    // All the lines are applied in one pass and one undo step
+    replaceBlocks(replacedBlockNumbers, replacedBlocks, "Replace All");
+    updateWordEditor();
 
-                if (wordText != "" && wordText[wordText.size()-1] == '?'){
-                    wordText = wordText.left(wordText.size() - 1);
+    return replacementCount;
+}
 
-                }
-                if (wordText != "" && wordText[wordText.size()-1] == '!'){
-                    wordText = wordText.left(wordText.size() - 1);
+block Editor::replaceInBlock(const block& a_block, const QRegularExpression& expression,
+                             const QString& replacement, bool expandGroups, int& replacementCount) const
+{
+    auto& text = a_block.text();
 
-                }
-                if (wordText != "" && wordText[wordText.size()-1] == ','){
-                    wordText = wordText.left(wordText.size() - 1);
+    struct Replacement
+    {
+        qsizetype start;
+        qsizetype end;
+        QString text;
+    };
+    QVector<Replacement> replacements;
+
+    QString newText;
+    qsizetype copied = 0;
+    for (auto it = expression.globalMatch(text); it.hasNext();) {
+        auto match = it.next();
+        Replacement a_replacement{match.capturedStart(), match.capturedEnd(),
+                                  replacementText(replacement, match, expandGroups)};
+        newText.append(QStringView(text).sliced(copied, a_replacement.start - copied)).append(a_replacement.text);
+        copied = a_replacement.end;
+        replacements.append(a_replacement);
+    }
+    if (replacements.isEmpty())
+        return a_block;
+
+    newText.append(QStringView(text).sliced(copied));
+    replacementCount += replacements.size();
+
+    // Words whose matches stay inside them are edited in place and keep
+    // their timestamp and tags
+    QVector<WordSpan> spans;
+    WordTokenizer tokenizer(text);
+    for (WordSpan span; tokenizer.next(span);)
+        spans.append(span);
+
+    auto words = a_block.words();
+    bool inPlace = spans.size() == words.size();
+    for (int w = 0, r = 0; w < spans.size() && inPlace && r < replacements.size(); w++) {
+        auto spanEnd = spans[w].start + spans[w].text.size();
+        if (replacements[r].start > spanEnd)
+            continue;
+
+        if (words[w].text != spans[w].text) {
+            inPlace = false;
+            break;
+        }
 
-                }
-                static QRegularExpression regex("([0-1][0-9]|2[0-3]):([0-5][0-9]):([0-5][0-9])(\\.[0-9]+)?");
-                bool match = regex.match(wordText).hasMatch();
-                if (match) {
-                    continue;
-                    // the string is a valid time in the format "HH:MM:SS.f"
-                }
-                if (!isWordValid(wordText,
-                                 m_dictionary,
-                                 m_english_dictionary,
-                                 m_transcriptLang)) {
-                    invalidWords.insert(i, j);
-                }
-                if(!m_blocks[i].words[j].tagList.empty()){
-                    taggedWords.insert(i,j);
-                }
+        QString wordText;
+        auto wordCopied = spans[w].start;
+        for (; r < replacements.size() && replacements[r].start <= spanEnd; r++) {
+            if (replacements[r].end > spanEnd || replacements[r].text.contains(u' ')) {
+                inPlace = false;
+                break;
             }
-
+            wordText.append(QStringView(text).sliced(wordCopied, replacements[r].start - wordCopied))
+                    .append(replacements[r].text);
+            wordCopied = replacements[r].end;
         }
-    }
+        wordText.append(QStringView(text).sliced(wordCopied, spanEnd - wordCopied));
 
-    m_highlighter->setInvalidBlocks(invalidBlocks);
-    m_highlighter->setTaggedBlocks(taggedBlocks);
-    m_highlighter->setInvalidWords(invalidWords);
-    m_highlighter->setTaggedWords(taggedWords);
-    m_highlighter->setEditedWords(editedWords);
-    updateWordEditor();
-    if(realTimeDataSaver){
-        transcriptSave();
+        words[w].text = wordText;
+        words[w].isEdited = true;
+    }
+    if (inPlace) {
+        auto replacedBlock = a_block;
+        replacedBlock.setWords(words);
+        return replacedBlock;
     }
 
-    // {
-    //     QMutexLocker locker(&queueMutex);
-    //     taskQueue.enqueue({
-    //         QVariant(position),
-    //         QVariant(charsRemoved),
-    //         QVariant(charsAdded),
-    //         QVariant(textCursor().blockNumber()),
-    //         QVariant(document()->blockCount()),
-    //         QVariant::fromValue(currentBlockFromEditor),
-    //         QVariant::fromValue(currentBlockFromData)
-    //     });
-    // }
+    // Otherwise the words are matched up like a typed edit
+    block editedBlock;
+    editedBlock.speaker = a_block.speaker;
+    editedBlock.setText(newText);
+    return mergeEditedBlock(a_block, editedBlock);
+}
 
-    // std::cerr << "Enqueued task\n";
+ValidationContext Editor::validationContext() const
+{
+    auto& dictionaryService = DictionaryService::getInstance();
+    return {m_dictionary, dictionaryService.correctedWords(m_transcriptLang), m_english_dictionary,
+            dictionaryService.affixes(m_transcriptLang), dictionaryService.affixes("english"),
+            m_transcriptLang, m_punctuation};
+}
 
-    // QMetaObject::invokeMethod(this, "processNextTask", Qt::QueuedConnection);
+void Editor::indexBlock(int blockNumber)
+{
+    // Blocks share the interned name
+    m_blocks[blockNumber].speaker = m_speakerIndex.add(blockNumber, m_blocks[blockNumber].speaker);
+
+    QString keyBuffer;
+    auto& a_block = std::as_const(m_blocks)[blockNumber];
+    for (int i = 0; i < a_block.wordCount(); i++) {
+        auto key = WordTokenizer::normalize(a_block.wordText(i), keyBuffer);
+        if (key.isEmpty() || WordTokenizer::containsTime(key))
+            continue;
+        m_wordIndex.add(key, {blockNumber, i});
+        m_transcriptWords.add(key);
+    }
+}
 
-    // debounceTimer->start();
-    // handleContentChanged();
+void Editor::unindexBlock(int blockNumber)
+{
+    m_speakerIndex.remove(blockNumber, m_blocks[blockNumber].speaker);
 
+    QString keyBuffer;
+    auto& a_block = std::as_const(m_blocks)[blockNumber];
+    for (int i = 0; i < a_block.wordCount(); i++) {
+        auto key = WordTokenizer::normalize(a_block.wordText(i), keyBuffer);
+        if (key.isEmpty() || WordTokenizer::containsTime(key))
+            continue;
+        m_wordIndex.remove(key, {blockNumber, i});
+        m_transcriptWords.add(key, -1);
+    }
 }
 
-// void Editor::processNextTask() {
+void Editor::rebuildIndexes()
+{
+    m_wordIndex.clear();
+    m_transcriptWords.clear();
+    m_speakerIndex.clear();
+    for (int i = 0; i < m_blocks.size(); i++)
+        indexBlock(i);
+}
 
-//     std::cerr << "Processing next task\n";
+void Editor::appendBlockText(QString& text, const block& a_block) const
+{
+    text.append(u'{').append(a_block.speaker).append(u"}: ").append(a_block.text());
+}
 
-//     if (taskQueue.isEmpty())
-//         return;
+void Editor::spliceBlocks(int first, int count, const QVector<block>& blocks)
+{
+    int newCount = blocks.size();
+    int blocksAdded = newCount - count;
+    m_revision++;
+
+    for (int i = first; i < first + count; i++)
+        unindexBlock(i);
+    if (blocksAdded > 0) {
+        m_wordIndex.insertBlocks(first + count, blocksAdded);
+        m_speakerIndex.insertBlocks(first + count, blocksAdded);
+    }
+    else if (blocksAdded < 0) {
+        m_wordIndex.removeBlocks(first + newCount, -blocksAdded);
+        m_speakerIndex.removeBlocks(first + newCount, -blocksAdded);
+    }
+
+    // Replaced in place, then the difference is inserted or removed in one go
+    bool validationCached = m_blockValidation.size() == m_blocks.size();
+    for (int i = 0; i < count && i < newCount; i++)
+        m_blocks[first + i] = blocks[i];
+    if (blocksAdded > 0) {
+        m_blocks.insert(first + count, blocksAdded, block());
+        for (int i = count; i < newCount; i++)
+            m_blocks[first + i] = blocks[i];
+        if (validationCached)
+            m_blockValidation.insert(first + count, blocksAdded, BlockValidation());
+    }
+    else if (blocksAdded < 0) {
+        m_blocks.remove(first + newCount, -blocksAdded);
+        if (validationCached)
+            m_blockValidation.remove(first + newCount, -blocksAdded);
+    }
+
+    for (int i = first; i < first + newCount; i++)
+        indexBlock(i);
+    m_timeIndex.replace(m_blocks, first, count, newCount);
+
+    // A parked cursor stays on its block, or on the last of those replacing it
+    if (m_parkedBlock >= first + count)
+        m_parkedBlock += blocksAdded;
+    else if (m_parkedBlock >= first)
+        m_parkedBlock = qMin(qMin(m_parkedBlock, first + qMax(newCount - 1, 0)), int(m_blocks.size()) - 1);
+
+    // A running background validation has stale block numbers once lines moved
+    if (!validationCached || (blocksAdded && m_validationWatcher.isRunning()))
+        startValidation();
+    if (newCount)
+        revalidateBlocks(first, first + newCount - 1);
+}
 
-//     if (!taskSemaphore.tryAcquire()) {
-//         return;
-//     }
+void Editor::replaceBlocks(int first, int count, const QVector<block>& blocks)
+{
+    if (!count && blocks.isEmpty())
+        return;
+    m_undoStack->push(new BlockEditCommand(this, first, m_blocks.mid(first, count), blocks));
+}
 
-//     QVariantList task;
-//     {
-//         QMutexLocker locker(&queueMutex);
-//         if (taskQueue.isEmpty()) {  // Check again under lock
-//             taskSemaphore.release();
-//             return;
-//         }
-//         task = taskQueue.dequeue();
-//     }
+void Editor::replaceBlocks(const QVector<int>& blockNumbers, const QVector<block>& blocks, const QString& text)
+{
+    if (blockNumbers.isEmpty())
+        return;
+
+    QVector<block> oldBlocks;
+    oldBlocks.reserve(blockNumbers.size());
+    for (auto blockNumber: blockNumbers)
+        oldBlocks.append(m_blocks[blockNumber]);
+    m_undoStack->push(new BlockBatchCommand(this, blockNumbers, oldBlocks, blocks, text));
+}
+
+void Editor::undo()
+{
+    m_undoStack->undo();
+    updateWordEditor();
+}
 
-//     int position = task[0].toInt();
-//     int charsRemoved = task[1].toInt();
-//     int charsAdded = task[2].toInt();
-//     int currentBlockNumber = task[3].toInt();
-//     int blockCount = task[4].toInt();
-//     block currentBlockFromEditor = task[5].value<block>();
-//     block currentBlockFromData = task[6].value<block>();
+void Editor::redo()
+{
+    m_undoStack->redo();
+    updateWordEditor();
+}
 
-//     auto* worker = new TaskRunner(
-//         this,
-//         task[0].toInt(),
-//         task[1].toInt(),
-//         task[2].toInt(),
-//         task[3].toInt(),
-//         task[4].toInt(),
-//         task[5].value<block>(),
-//         task[6].value<block>()
-//         );
+void Editor::applyBlocks(int first, int count, const QVector<block>& blocks)
+{
+    int newCount = blocks.size();
+    if (!count && !newCount)
+        return;
 
-//     std::cerr << "Starting worker\n";
-//     QThreadPool::globalInstance()->start(worker);
-// }
+    // Lines can only be patched while the document mirrors its window of m_blocks
+    if (document()->blockCount() != m_windowCount || m_windowFirst + m_windowCount > m_blocks.size()) {
+        m_revision++;
+        m_blocks.remove(first, count);
+        for (int i = 0; i < newCount; i++)
+            m_blocks.insert(first + i, blocks[i]);
+        setContent();
+        return;
+    }
 
-// void Editor::processContentChange(int position, int charsRemoved, int charsAdded, int currentBlockNumber, int blockCount,
-//                                   block currentBlockFromEditor, block currentBlockFromData) {
+    // Blocks across an end of the window are paged in, and so is a neighbour
+    // of blocks removing the whole window, which can't be left without lines
+    int windowEnd = m_windowFirst + m_windowCount;
+    if (first < windowEnd && first + count > m_windowFirst
+        && (first < m_windowFirst || first + count > windowEnd))
+        moveWindow(qMin(m_windowFirst, first), qMax(windowEnd, first + count));
+    windowEnd = m_windowFirst + m_windowCount;
+    if (!newCount && first <= m_windowFirst && first + count >= windowEnd) {
+        moveWindow(first - 1, first + count + 1);
+        windowEnd = m_windowFirst + m_windowCount;
+    }
+    bool inWindow = first >= m_windowFirst && first + count <= windowEnd;
+
+    spliceBlocks(first, count, blocks);
+
+    // Blocks before the window only shift it, those after it aren't shown
+    if (!inWindow) {
+        if (first < m_windowFirst)
+            m_windowFirst += newCount - count;
+        updateTimeStampArea();
+        updateLineNumbers();
+        updateBlockScrollBar();
+        return;
+    }
 
-//     std::cerr << "Processing content change\n";
-//     QMutexLocker locker(&queueMutex);
-//     std::cerr << "After locker\n";
+    QString text = windowText(first, first + newCount);
+    int line = first - m_windowFirst;
+
+    // contentsChange is emitted when the outermost edit block ends, so callers
+    // grouping several replacements keep settingContent set until then
+    bool wasSettingContent = settingContent;
+    settingContent = true;
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    if (count) {
+        auto firstBlock = document()->findBlockByNumber(line);
+        auto lastBlock = document()->findBlockByNumber(line + count - 1);
+        int start = firstBlock.position();
+        int end = lastBlock.position() + lastBlock.length() - 1;
+
+        // Removed lines take a line break with them
+        if (!newCount) {
+            if (lastBlock.next().isValid())
+                end++;
+            else if (start > 0)
+                start--;
+        }
+        cursor.setPosition(start);
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+    }
+    else if (line < document()->blockCount()) {
+        cursor.setPosition(document()->findBlockByNumber(line).position());
+        cursor.insertText(text + u'\n');
+    }
+    else {
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(u'\n' + text);
+    }
+    cursor.endEditBlock();
+    settingContent = wasSettingContent;
+    m_windowCount += newCount - count;
+
+    if (newCount)
+        applyValidation(first, first + newCount - 1);
+
+    updatePlaybackHighlight();
+    highlightOccurrences();
+    updateTimeStampArea();
+    updateLineNumbers();
+    updateBlockScrollBar();
+    // Many inserted lines make the window grow past its margins
+    scheduleWindowUpdate();
+}
 
+void Editor::applyBlocks(const QVector<int>& blockNumbers, const QVector<block>& blocks)
+{
+    if (blockNumbers.isEmpty())
+        return;
+    m_revision++;
 
-//     std::cerr << "Task completed\n";
-// }
+    // Lines can only be patched while the document mirrors its window of m_blocks
+    if (document()->blockCount() != m_windowCount || m_windowFirst + m_windowCount > m_blocks.size()) {
+        for (int i = 0; i < blockNumbers.size(); i++)
+            m_blocks[blockNumbers[i]] = blocks[i];
+        setContent();
+        return;
+    }
 
-// void Editor::handleContentChanged() {
+    for (int i = 0; i < blockNumbers.size(); i++) {
+        unindexBlock(blockNumbers[i]);
+        m_blocks[blockNumbers[i]] = blocks[i];
+        indexBlock(blockNumbers[i]);
+    }
+    m_timeIndex.update(m_blocks, blockNumbers);
 
+    bool validationCached = m_blockValidation.size() == m_blocks.size();
+    if (validationCached) {
+        for (auto blockNumber: blockNumbers)
+            revalidateBlocks(blockNumber, blockNumber);
+    }
 
+    bool wasSettingContent = settingContent;
+    settingContent = true;
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    QString text;
+    for (auto blockNumber: blockNumbers) {
+        // Blocks outside the window are only changed in m_blocks
+        auto textBlock = findTextBlock(blockNumber);
+        if (!textBlock.isValid())
+            continue;
+        text.resize(0);
+        appendBlockText(text, m_blocks[blockNumber]);
+        cursor.setPosition(textBlock.position());
+        cursor.setPosition(textBlock.position() + textBlock.length() - 1, QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+    }
+    cursor.endEditBlock();
+    settingContent = wasSettingContent;
 
-// }
+    if (validationCached) {
+        for (auto blockNumber: blockNumbers)
+            applyValidation(blockNumber, blockNumber);
+    }
+    else
+        startValidation();
 
-bool Editor::isWordValid(const QString& wordText,
-                 const QStringList& primaryDict,
-                 const QStringList& englishDict,
-                 const QString& transcriptLang) {
+    updatePlaybackHighlight();
+    highlightOccurrences();
+    updateTimeStampArea();
+}
 
-    bool inPrimaryDict = std::binary_search(primaryDict.begin(),
-                                            primaryDict.end(),
-                                            wordText);
-    if (inPrimaryDict) return true;
+void Editor::revalidateBlocks(int first, int last)
+{
+    first = qMax(first, 0);
+    last = qMin(last, static_cast<int>(m_blocks.size()) - 1);
 
-    if (transcriptLang != "english") {
-        return std::binary_search(englishDict.begin(),
-                                  englishDict.end(),
-                                  wordText);
+    auto context = validationContext();
+    bool validationRunning = m_validationWatcher.isRunning();
+    for (int i = first; i <= last && i < m_blockValidation.size(); i++) {
+        m_blockValidation[i] = BlockValidator::validate(m_blocks[i], context);
+        // Results of the running validation were computed from the old text
+        if (validationRunning)
+            m_locallyValidated.insert(i);
     }
+}
 
-    return false;
+void Editor::startValidation()
+{
+    m_validationWatcher.cancel();
+    m_locallyValidated.clear();
+    m_blockValidation.resize(m_blocks.size());
+
+    int firstVisible = firstVisibleBlockNumber();
+    int lastVisible = lastVisibleBlockNumber();
+
+    m_validationWatcher.setFuture(QtConcurrent::run(&BlockValidator::validateBlocks,
+                                                    ++m_validationGeneration,
+                                                    m_blocks,
+                                                    validationContext(),
+                                                    firstVisible,
+                                                    lastVisible));
+}
+
+void Editor::applyValidationResults(int begin, int end)
+{
+    for (int i = begin; i < end; i++) {
+        auto chunk = m_validationWatcher.resultAt(i);
+        if (chunk.generation != m_validationGeneration)
+            continue;
+
+        for (int j = 0; j < chunk.validations.size(); j++) {
+            int blockNumber = chunk.firstBlock + j;
+            if (blockNumber >= m_blockValidation.size())
+                break;
+            if (m_locallyValidated.contains(blockNumber))
+                continue;
+            m_blockValidation[blockNumber] = chunk.validations[j];
+        }
+        // Blocks paged out get their flags once they are paged in
+        if (!chunk.validations.isEmpty())
+            applyValidation(chunk.firstBlock, chunk.firstBlock + chunk.validations.size() - 1);
+    }
+}
+
+void Editor::applyValidation(int first, int last)
+{
+    if (!m_highlighter)
+        return;
+
+    if (last < 0 || last >= m_blockValidation.size())
+        last = m_blockValidation.size() - 1;
+    // Only the blocks paged in have a line to attach to
+    first = qMax(first, m_windowFirst);
+    last = qMin(last, m_windowFirst + m_windowCount - 1);
+
+    auto textBlock = findTextBlock(first);
+    for (int i = first; i <= last && textBlock.isValid(); i++, textBlock = textBlock.next())
+        m_highlighter->setBlockValidation(textBlock, m_blockValidation[i]);
 }
 
 
@@ -2040,7 +2274,7 @@ void Editor::jumpToHighlightedLine()
 {
     if (highlightedBlock == -1)
         return;
-    QTextCursor cursor(document()->findBlockByNumber(highlightedBlock));
+    QTextCursor cursor = blockCursor(highlightedBlock);
     setTextCursor(cursor);
 }
 
@@ -2050,12 +2284,13 @@ void Editor::splitLine(const QTime& elapsedTime)
         return;
 
     // qInfo() << "Split Line - - - - - -- - - - -- - \n";  // Disabled debug
+    restoreCursor();
     auto cursor = textCursor();
     // if (cursor.blockNumber() != highlightedBlock)
     //     return;
     int positionInBlock = cursor.positionInBlock();
     auto blockText = cursor.block().text();
-    auto blockNumber = cursor.blockNumber();
+    auto blockNumber = cursorBlockNumber();
 
     auto textBeforeCursor = blockText.left(positionInBlock);
     auto textAfterCursor = blockText.right(blockText.size() - positionInBlock);
@@ -2104,54 +2339,44 @@ void Editor::splitLine(const QTime& elapsedTime)
     // m_blocks[highlightedBlock].text = textBeforeCursor.trimmed();
     // m_blocks[highlightedBlock].timeStamp = elapsedTime;
 
-    if (m_blocks[cursor.blockNumber()].speaker != "" || blockText.contains("{}:"))
+    if (m_blocks[blockNumber].speaker != "" || blockText.contains("{}:"))
         wordNumber--;
-    if (wordNumber < 0 || wordNumber >= m_blocks[cursor.blockNumber()].words.size())
+    if (wordNumber < 0 || wordNumber >= m_blocks[blockNumber].wordCount())
         return;
 
 
-    if (textBeforeCursor.contains("}:"))
-        textBeforeCursor = textBeforeCursor.split("}:").last();
-
-    if (textAfterCursor.contains("{"))
-        textAfterCursor = textAfterCursor.split("{").first();
-
-
-    auto timeStampOfCutWord = m_blocks[cursor.blockNumber()].words[wordNumber].timeStamp;
-    auto tagsOfCutWord = m_blocks[cursor.blockNumber()].words[wordNumber].tagList;
+    // The texts of both lines are joined from their words
+    auto splitBlock = m_blocks[blockNumber];
+    auto wordsBefore = splitBlock.words();
+    auto timeOfCutWord = wordsBefore[wordNumber].time;
+    auto tagsOfCutWord = wordsBefore[wordNumber].tagList;
     QVector<word> words;
-    int sizeOfWordsAfter = m_blocks[cursor.blockNumber()].words.size() - wordNumber - 1;
+    int sizeOfWordsAfter = wordsBefore.size() - wordNumber - 1;
 
     //checking
     if (cutWordRight != "")
-        words.append(makeWord(timeStampOfCutWord, cutWordRight, tagsOfCutWord, "true"));
+        words.append(word(timeOfCutWord, cutWordRight, tagsOfCutWord, true));
 
-    for (int i = 0; i < sizeOfWordsAfter; i++) {
-        words.append(m_blocks[cursor.blockNumber()].words[wordNumber + 1]);
-        m_blocks[cursor.blockNumber()].words.removeAt(wordNumber + 1);
-    }
+    for (int i = 0; i < sizeOfWordsAfter; i++)
+        words.append(wordsBefore[wordNumber + 1 + i]);
+    wordsBefore.resize(wordNumber + 1);
 
     if (cutWordLeft == "")
-        m_blocks[cursor.blockNumber()].words.removeAt(wordNumber);
+        wordsBefore.removeAt(wordNumber);
     else {
-        m_blocks[cursor.blockNumber()].words[wordNumber].text = cutWordLeft;
-        m_blocks[cursor.blockNumber()].words[wordNumber].timeStamp = elapsedTime;
+        wordsBefore[wordNumber].text = cutWordLeft;
+        wordsBefore[wordNumber].setTimeStamp(elapsedTime);
     }
 
-    block blockToInsert = {m_blocks[cursor.blockNumber()].timeStamp,
-                           textAfterCursor.trimmed(),
-                           m_blocks[cursor.blockNumber()].speaker,
-                           m_blocks[cursor.blockNumber()].tagList,
-                           words};
-    m_blocks.insert(cursor.blockNumber() + 1, blockToInsert);
+    block blockToInsert(splitBlock.time, splitBlock.speaker, splitBlock.tagList, words);
 
-    m_blocks[cursor.blockNumber()].text = textBeforeCursor.trimmed();
-    m_blocks[cursor.blockNumber()].timeStamp = elapsedTime;
+    splitBlock.setWords(wordsBefore);
+    splitBlock.setTimeStamp(elapsedTime);
 
-    setContent();
+    replaceBlocks(blockNumber, 1, {splitBlock, blockToInsert});
     updateWordEditor();
 
-    int totalBlocks = document()->blockCount();
+    int totalBlocks = m_blocks.size();
     if (blockNumber >= totalBlocks)
     {
         blockNumber = totalBlocks - 1;
@@ -2161,7 +2386,7 @@ void Editor::splitLine(const QTime& elapsedTime)
         blockNumber = 0;
     }
 
-    QTextCursor newCursor(document()->findBlockByNumber(blockNumber));
+    QTextCursor newCursor = blockCursor(blockNumber);
     newCursor.movePosition(QTextCursor::EndOfBlock);
     setTextCursor(newCursor);
 
@@ -2175,23 +2400,21 @@ void Editor::splitLine(const QTime& elapsedTime)
 
 void Editor::mergeUp()
 {
-    auto blockNumber = textCursor().blockNumber();
+    auto blockNumber = cursorBlockNumber();
     auto previousBlockNumber = blockNumber - 1;
 
     if (m_blocks.isEmpty() || blockNumber == 0 || m_blocks[blockNumber].speaker != m_blocks[previousBlockNumber].speaker)
         return;
 
-    auto currentWords = m_blocks[blockNumber].words;
+    auto mergedBlock = m_blocks[previousBlockNumber];
 
-    m_blocks[previousBlockNumber].words.append(currentWords);                 // Add current words to previous block
-    m_blocks[previousBlockNumber].timeStamp = m_blocks[blockNumber].timeStamp;  // Update time stamp of previous block
-    m_blocks[previousBlockNumber].text.append(" " + m_blocks[blockNumber].text);// Append text to previous block
+    mergedBlock.appendWords(m_blocks[blockNumber]);   // Add current words and text to previous block
+    mergedBlock.time = m_blocks[blockNumber].time;    // Update time stamp of previous block
 
-    m_blocks.removeAt(blockNumber);
-    setContent();
+    replaceBlocks(previousBlockNumber, 2, {mergedBlock});
     updateWordEditor();
 
-    QTextCursor cursor(document()->findBlockByNumber(previousBlockNumber));
+    QTextCursor cursor = blockCursor(previousBlockNumber);
     setTextCursor(cursor);
     centerCursor();
 
@@ -2205,27 +2428,22 @@ void Editor::mergeUp()
 
 void Editor::mergeDown()
 {
-    auto blockNumber = textCursor().blockNumber();
+    auto blockNumber = cursorBlockNumber();
     auto nextBlockNumber = blockNumber + 1;
 
     if (m_blocks.isEmpty() || blockNumber == m_blocks.size() - 1 || m_blocks[blockNumber].speaker != m_blocks[nextBlockNumber].speaker)
         return;
 
-    auto currentWords = m_blocks[blockNumber].words;
-
-    auto temp = m_blocks[nextBlockNumber].words;
-    m_blocks[nextBlockNumber].words = currentWords;
-    m_blocks[nextBlockNumber].words.append(temp);
+    // The merged line keeps the timestamp and tags of the next one
+    auto mergedBlock = m_blocks[blockNumber];
+    mergedBlock.appendWords(m_blocks[nextBlockNumber]);
+    mergedBlock.time = m_blocks[nextBlockNumber].time;
+    mergedBlock.tagList = m_blocks[nextBlockNumber].tagList;
 
-    auto tempText = m_blocks[nextBlockNumber].text;
-    m_blocks[nextBlockNumber].text = m_blocks[blockNumber].text;
-    m_blocks[nextBlockNumber].text.append(" " + tempText);
-
-    m_blocks.removeAt(blockNumber);
-    setContent();
+    replaceBlocks(blockNumber, 2, {mergedBlock});
     updateWordEditor();
 
-    QTextCursor cursor(document()->findBlockByNumber(blockNumber));
+    QTextCursor cursor = blockCursor(blockNumber);
     setTextCursor(cursor);
     centerCursor();
 
@@ -2243,12 +2461,8 @@ void Editor::createChangeSpeakerDialog()
     m_changeSpeaker->setModal(true);
     m_changeSpeaker->setAttribute(Qt::WA_DeleteOnClose);
 
-    QSet<QString> speakers;
-    for (auto& a_block: std::as_const(m_blocks))
-        speakers.insert(a_block.speaker);
-
-    m_changeSpeaker->addItems(speakers.values());
-    m_changeSpeaker->setCurrentSpeaker(m_blocks.at(textCursor().blockNumber()).speaker);
+    m_changeSpeaker->addItems(m_speakerIndex.speakers());
+    m_changeSpeaker->setCurrentSpeaker(m_blocks.at(cursorBlockNumber()).speaker);
 
     connect(m_changeSpeaker,
             &ChangeSpeakerDialog::accepted,
@@ -2269,7 +2483,7 @@ void Editor::createTimePropagationDialog()
     m_propagateTime->setModal(true);
     m_propagateTime->setAttribute(Qt::WA_DeleteOnClose);
 
-    m_propagateTime->setBlockRange(textCursor().blockNumber() + 1, blockCount());
+    m_propagateTime->setBlockRange(cursorBlockNumber() + 1, m_blocks.size());
 
     connect(m_propagateTime,
             &TimePropagationDialog::accepted,
@@ -2293,7 +2507,7 @@ void Editor::createTagSelectionDialog()
     m_selectTag->setModal(true);
     m_selectTag->setAttribute(Qt::WA_DeleteOnClose);
 
-    m_selectTag->markExistingTags(m_blocks[textCursor().blockNumber()].tagList);
+    m_selectTag->markExistingTags(m_blocks[cursorBlockNumber()].tagList);
 
     connect(m_selectTag,
             &TagSelectionDialog::accepted,
@@ -2307,16 +2521,17 @@ void Editor::createTagSelectionDialog()
 
 void Editor::insertTimeStamp(const QTime& elapsedTime)
 {
-    auto blockNumber = textCursor().blockNumber();
+    auto blockNumber = cursorBlockNumber();
 
     if (m_blocks.size() <= blockNumber)
         return;
 
-    m_blocks[blockNumber].timeStamp = elapsedTime;
+    auto stampedBlock = m_blocks[blockNumber];
+    stampedBlock.setTimeStamp(elapsedTime);
 
     dontUpdateWordEditor = true;
-    setContent();
-    QTextCursor cursor(document()->findBlockByNumber(blockNumber));
+    replaceBlocks(blockNumber, 1, {stampedBlock});
+    QTextCursor cursor = blockCursor(blockNumber);
     cursor.movePosition(QTextCursor::EndOfBlock);
     setTextCursor(cursor);
     centerCursor();
@@ -2331,6 +2546,7 @@ void Editor::changeTranscriptLang()
 {
     auto newLang = QInputDialog::getText(this, "Change Transcript Language", "Current Language: " + m_transcriptLang);
     m_transcriptLang = newLang.toLower();
+    m_revision++;
 
     loadDictionary();
 }
@@ -2347,20 +2563,10 @@ void Editor::speakerWiseJump(const QString& jumpDirection)
     auto speakerName = m_blocks[blockNumber].speaker;
     int blockToJump{-1};
 
-    if (jumpDirection == "up") {
-        for (int i = blockNumber - 1; i >= 0; i--)
-            if (speakerName == m_blocks[i].speaker) {
-                blockToJump = i;
-                break;
-            }
-    }
-    else if (jumpDirection == "down") {
-        for (int i = blockNumber + 1; i < m_blocks.size(); i++)
-            if (speakerName == m_blocks[i].speaker) {
-                blockToJump = i;
-                break;
-            }
-    }
+    if (jumpDirection == "up")
+        blockToJump = m_speakerIndex.previousBlock(speakerName, blockNumber);
+    else if (jumpDirection == "down")
+        blockToJump = m_speakerIndex.nextBlock(speakerName, blockNumber);
 
     if (blockToJump == -1) {
         emit message("Couldn't find a block to jump");
@@ -2368,13 +2574,8 @@ void Editor::speakerWiseJump(const QString& jumpDirection)
     }
 
     QTime timeToJump(0, 0);
-
-    for (int i = blockToJump - 1; i >= 0; i--) {
-        if (m_blocks[i].timeStamp.isValid()) {
-            timeToJump = m_blocks[i].timeStamp;
-            break;
-        }
-    }
+    if (m_timeIndex.previousBlockTime(blockToJump).isValid())
+        timeToJump = m_timeIndex.previousBlockTime(blockToJump);
 
     emit jumpToPlayer(timeToJump);
 }
@@ -2388,7 +2589,7 @@ void Editor::wordWiseJump(const QString& jumpDirection)
         return;
     }
 
-    auto& highlightedBlockWords = m_blocks[highlightedBlock].words;
+    auto& highlightedBlockData = std::as_const(m_blocks)[highlightedBlock];
     QTime timeToJump;
     int wordToJump{-1};
 
@@ -2397,7 +2598,7 @@ void Editor::wordWiseJump(const QString& jumpDirection)
     else if (jumpDirection == "right")
         wordToJump = wordNumber + 1;
 
-    if (wordToJump < 0 || wordToJump >= highlightedBlockWords.size()) {
+    if (wordToJump < 0 || wordToJump >= highlightedBlockData.wordCount()) {
         emit message("Can't jump, end of block reached!", 2000);
         return;
     }
@@ -2405,24 +2606,15 @@ void Editor::wordWiseJump(const QString& jumpDirection)
     if (jumpDirection == "left") {
         if (wordToJump == 0){
             timeToJump = QTime(0, 0);
-            for (int i = highlightedBlock - 1; i >= 0; i--) {
-                if (m_blocks[i].timeStamp.isValid()) {
-                    timeToJump = m_blocks[i].timeStamp;
-                    break;
-                }
-            }
-        }
-        else {
-            for (int i = wordToJump - 1; i >= 0; i--)
-                if (highlightedBlockWords[i].timeStamp.isValid()) {
-                    timeToJump = highlightedBlockWords[i].timeStamp;
-                    break;
-                }
+            if (m_timeIndex.previousBlockTime(highlightedBlock).isValid())
+                timeToJump = m_timeIndex.previousBlockTime(highlightedBlock);
         }
+        else
+            timeToJump = m_timeIndex.previousWordTime(highlightedBlock, wordToJump);
     }
 
     if (jumpDirection == "right")
-        timeToJump = highlightedBlockWords[wordToJump - 1].timeStamp;
+        timeToJump = TranscriptTime::toTime(highlightedBlockData.wordTime(wordToJump - 1));
 
     if (timeToJump.isNull()) {
         emit message("Couldn't find a word to jump to");
@@ -2445,22 +2637,18 @@ void Editor::blockWiseJump(const QString& jumpDirection)
     else if (jumpDirection == "down")
         blockToJump = highlightedBlock + 1;
 
-    if (blockToJump == -1 || blockToJump == blockCount())
+    if (blockToJump == -1 || blockToJump == m_blocks.size())
         return;
 
     QTime timeToJump;
 
     if (jumpDirection == "up") {
         timeToJump = QTime(0, 0);
-        for (int i = blockToJump - 1; i >= 0; i--) {
-            if (m_blocks[i].timeStamp.isValid()) {
-                timeToJump = m_blocks[i].timeStamp;
-                break;
-            }
-        }
+        if (m_timeIndex.previousBlockTime(blockToJump).isValid())
+            timeToJump = m_timeIndex.previousBlockTime(blockToJump);
     }
     else if (jumpDirection == "down")
-        timeToJump = m_blocks[highlightedBlock].timeStamp;
+        timeToJump = m_blocks[highlightedBlock].timeStamp();
 
     emit jumpToPlayer(timeToJump);
 
@@ -2474,6 +2662,7 @@ void Editor::useTransliteration(bool value, const QString& langCode)
 
 void Editor::suggest(QString suggest)
 {
+    restoreCursor();
 
     QTextCursor cursor = textCursor();
 
@@ -2516,12 +2705,13 @@ void Editor::saveAsPDF()
 
 
     for (auto& a_block: std::as_const(m_blocks)) {
-        auto blockText = "<p>{" + a_block.speaker + "}: " + a_block.text + " {" + a_block.timeStamp.toString("hh:mm:ss.zzz") + "}<p>";
-        content_with_time_stamp.append(blockText + "\n\n");
+        content_with_time_stamp.append(u"<p>{").append(a_block.speaker).append(u"}: ").append(a_block.text()).append(u" {");
+        TimeCodec::append(content_with_time_stamp, a_block.time);
+        content_with_time_stamp.append(u"}<p>\n\n");
     }
 
     for (auto& a_block: std::as_const(m_blocks)) {
-        auto blockText = "<p>{" + a_block.speaker + "}: " + a_block.text+"<p>" ;
+        auto blockText = "<p>{" + a_block.speaker + "}: " + a_block.text()+"<p>" ;
         content_without_time_stamp.append(blockText + "\n\n");
     }
 
@@ -2556,8 +2746,9 @@ void Editor::saveAsTXT()    // save the transcript as a text file
     QString txtContent;
 
     for (auto& a_block : std::as_const(m_blocks)) {
-        auto blockText = "{" + a_block.speaker + "}: " + a_block.text + " {" + a_block.timeStamp.toString("hh:mm:ss.zzz") + "}\n";
-        txtContent.append(blockText + "\n");
+        txtContent.append(u'{').append(a_block.speaker).append(u"}: ").append(a_block.text()).append(u" {");
+        TimeCodec::append(txtContent, a_block.time);
+        txtContent.append(u"}\n\n");
     }
 
     QString txtSaveLocation = QFileDialog::getSaveFileName(this, "Export TXT", QString("/"), "*.txt");
@@ -2579,26 +2770,424 @@ void Editor::saveAsTXT()    // save the transcript as a text file
     }
 }
 
+int Editor::wordNumberAtCursor() const
+{
+    auto cursor = textCursor();
+    auto text = cursor.block().text();
+    auto position = cursor.positionInBlock();
+
+    WordTokenizer tokenizer(text, WordTokenizer::wordsStart(text));
+    int wordNumber = 0;
+    for (WordSpan span; tokenizer.next(span); wordNumber++) {
+        if (position >= span.start && position <= span.start + span.text.size())
+            return wordNumber;
+    }
+    return -1;
+}
+
+bool Editor::isWordFlaggedInvalid(int blockNumber, int wordNumber) const
+{
+    if (blockNumber < 0 || blockNumber >= m_blockValidation.size() || blockNumber >= m_blocks.size()
+        || wordNumber < 0 || wordNumber >= m_blocks[blockNumber].wordCount())
+        return false;
+
+    auto& invalidWords = m_blockValidation[blockNumber].invalidWords;
+    return wordNumber < invalidWords.size() && invalidWords.testBit(wordNumber);
+}
+
+QStringList Editor::spellingSuggestions(const QString& wordText) const
+{
+    QString keyBuffer;
+    auto key = WordTokenizer::lowercase(WordTokenizer::strip(wordText, m_punctuation), keyBuffer);
+
+    auto& dictionaryService = DictionaryService::getInstance();
+    QStringList corrections;
+    if (auto corrector = dictionaryService.corrector(m_transcriptLang))
+        corrections = corrector->suggestions(key);
+
+    // The few words marked correct this session aren't indexed by the corrector
+    for (auto& correctedWord: dictionaryService.correctedWords(m_transcriptLang)) {
+        if (SpellingCorrector::editDistance(key, correctedWord, SpellingCorrector::maxDistance) <= SpellingCorrector::maxDistance
+            && !corrections.contains(correctedWord))
+            corrections << correctedWord;
+    }
+
+    // English words are accepted in every transcript, so they are suggested too
+    if (m_transcriptLang != "english") {
+        if (auto corrector = dictionaryService.corrector("english")) {
+            for (auto& correction: corrector->suggestions(key))
+                if (!corrections.contains(correction))
+                    corrections << correction;
+        }
+    }
+    return corrections;
+}
+
+void Editor::showWordStatus()
+{
+    // The status stays on the word the cursor left while its line is paged out
+    if (m_parkedBlock >= 0)
+        return;
+
+    int blockNumber = cursorBlockNumber();
+    int wordNumber = wordNumberAtCursor();
+
+    QString key;
+    if (blockNumber < m_blocks.size() && wordNumber >= 0 && wordNumber < m_blocks[blockNumber].wordCount()) {
+        QString keyBuffer;
+        key = WordTokenizer::normalize(m_blocks[blockNumber].wordText(wordNumber), keyBuffer).toString();
+        if (WordTokenizer::containsTime(key))
+            key.clear();
+    }
+
+    if (blockNumber == m_statusBlock && wordNumber == m_statusWord && key == m_statusKey)
+        return;
+    m_statusBlock = blockNumber;
+    m_statusWord = wordNumber;
+    m_statusKey = key;
+    highlightOccurrences();
+
+    if (key.isEmpty()) {
+        if (m_showingWordStatus) {
+            emit message("");
+            m_showingWordStatus = false;
+        }
+        return;
+    }
+
+    auto status = QString("\"%1\": %2 occurrences").arg(key).arg(m_wordIndex.count(key));
+    if (isWordFlaggedInvalid(blockNumber, wordNumber)) {
+        auto corrections = spellingSuggestions(m_blocks[blockNumber].wordText(wordNumber).toString());
+        if (!corrections.isEmpty())
+            status += " | Suggestions: " + corrections.join(", ");
+    }
+
+    emit message(status);
+    m_showingWordStatus = true;
+}
+
+void Editor::updateHighlightWindow()
+{
+    if (!m_highlighter)
+        return;
+
+    int firstVisible = firstVisibleBlock().blockNumber();
+    int lastVisible = cursorForPosition(QPoint(0, viewport()->height() - 1)).blockNumber();
+    m_highlighter->setWindow(firstVisible - highlightWindowMargin, lastVisible + highlightWindowMargin);
+}
+
+QTextBlock Editor::findTextBlock(int blockNumber) const
+{
+    if (blockNumber < m_windowFirst || blockNumber >= m_windowFirst + m_windowCount)
+        return {};
+    return document()->findBlockByNumber(blockNumber - m_windowFirst);
+}
+
+int Editor::cursorBlockNumber() const
+{
+    return m_parkedBlock >= 0 ? m_parkedBlock : m_windowFirst + textCursor().blockNumber();
+}
+
+int Editor::firstVisibleBlockNumber() const
+{
+    return m_windowFirst + firstVisibleBlock().blockNumber();
+}
+
+int Editor::lastVisibleBlockNumber() const
+{
+    return m_windowFirst + cursorForPosition(QPoint(0, viewport()->height() - 1)).blockNumber();
+}
+
+QString Editor::windowText(int first, int end) const
+{
+    // Built in a single allocation. Lines are kept as they are written,
+    // fromEditor() trims them anyway.
+    qsizetype size = 0;
+    for (int i = first; i < end; i++)
+        size += m_blocks[i].speaker.size() + m_blocks[i].text().size() + 5;
+
+    QString text;
+    text.reserve(size);
+    for (int i = first; i < end; i++) {
+        if (i > first)
+            text.append(u'\n');
+        appendBlockText(text, m_blocks[i]);
+    }
+    return text;
+}
+
+void Editor::moveWindow(int first, int end, bool rewrite)
+{
+    if (m_blocks.isEmpty())
+        return;
+    first = qBound(0, first, int(m_blocks.size()) - 1);
+    end = qBound(first + 1, end, int(m_blocks.size()));
+    int windowEnd = m_windowFirst + m_windowCount;
+    if (!rewrite && first == m_windowFirst && end == windowEnd)
+        return;
+    // Lines that don't mirror the window can't be kept
+    if (document()->blockCount() != m_windowCount)
+        rewrite = true;
+
+    // The view is put back on the same block, and the cursor is parked until
+    // its line is in the window again
+    int topBlock = firstVisibleBlockNumber();
+    int topLine = verticalScrollBar()->value() - firstVisibleBlock().firstLineNumber();
+    int anchorBlock = -1, anchorPosition = 0;
+    if (m_parkedBlock < 0) {
+        auto textCursor = this->textCursor();
+        m_parkedBlock = qMin(cursorBlockNumber(), int(m_blocks.size()) - 1);
+        m_parkedPosition = textCursor.positionInBlock();
+        if (textCursor.hasSelection()) {
+            auto anchorTextBlock = document()->findBlock(textCursor.anchor());
+            anchorBlock = m_windowFirst + anchorTextBlock.blockNumber();
+            anchorPosition = textCursor.anchor() - anchorTextBlock.position();
+        }
+    }
+
+    bool wasSettingContent = settingContent;
+    settingContent = true;
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    if (rewrite || end <= m_windowFirst || first >= windowEnd) {
+        cursor.select(QTextCursor::Document);
+        cursor.insertText(windowText(first, end));
+    }
+    else {
+        // The lines kept stay as they are, the others leave or enter at the
+        // ends of the document with their line break
+        if (end < windowEnd) {
+            auto lastBlock = document()->findBlockByNumber(end - m_windowFirst - 1);
+            cursor.setPosition(lastBlock.position() + lastBlock.length() - 1);
+            cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+        }
+        if (first > m_windowFirst) {
+            cursor.setPosition(0);
+            cursor.setPosition(document()->findBlockByNumber(first - m_windowFirst).position(), QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+        }
+        else if (first < m_windowFirst) {
+            cursor.setPosition(0);
+            cursor.insertText(windowText(first, m_windowFirst) + u'\n');
+        }
+        if (end > windowEnd) {
+            cursor.movePosition(QTextCursor::End);
+            cursor.insertText(u'\n' + windowText(windowEnd, end));
+        }
+    }
+    cursor.endEditBlock();
+    m_windowFirst = first;
+    m_windowCount = end - first;
+    settingContent = wasSettingContent;
+
+    // Lines entering the window, and those whose user data was merged into
+    // another line, get their flags from the cache
+    applyValidation(first, end - 1);
+
+    // A selection is kept when both of its ends are still in the window
+    auto cursorBlock = findTextBlock(m_parkedBlock);
+    if (cursorBlock.isValid()) {
+        QTextCursor restoredCursor(cursorBlock);
+        auto anchorTextBlock = findTextBlock(anchorBlock);
+        if (anchorTextBlock.isValid())
+            restoredCursor.setPosition(anchorTextBlock.position() + qMin(anchorPosition, anchorTextBlock.length() - 1));
+        restoredCursor.setPosition(cursorBlock.position() + qMin(m_parkedPosition, cursorBlock.length() - 1),
+                                   anchorTextBlock.isValid() ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor);
+        m_parkedBlock = -1;
+        setTextCursor(restoredCursor);
+    }
+    auto topTextBlock = findTextBlock(topBlock);
+    if (topTextBlock.isValid())
+        verticalScrollBar()->setValue(topTextBlock.firstLineNumber() + topLine);
+
+    updateHighlightWindow();
+    updatePlaybackHighlight();
+    highlightOccurrences();
+    updateTimeStampArea();
+    updateLineNumbers();
+    updateBlockScrollBar();
+}
+
+void Editor::showBlock(int blockNumber)
+{
+    if (blockNumber < 0 || blockNumber >= m_blocks.size() || findTextBlock(blockNumber).isValid())
+        return;
+    moveWindow(blockNumber - windowMargin, blockNumber + windowMargin + 1);
+}
+
+QTextCursor Editor::blockCursor(int blockNumber)
+{
+    showBlock(blockNumber);
+    return QTextCursor(findTextBlock(blockNumber));
+}
+
+void Editor::restoreCursor()
+{
+    if (m_parkedBlock < 0)
+        return;
+
+    // A parked cursor is always outside the window, paging its line in puts it back
+    showBlock(m_parkedBlock);
+    m_parkedBlock = -1;
+    ensureCursorVisible();
+}
+
+void Editor::scheduleWindowUpdate()
+{
+    if (m_windowUpdateQueued)
+        return;
+    m_windowUpdateQueued = true;
+    QMetaObject::invokeMethod(this, &Editor::updateWindow, Qt::QueuedConnection);
+}
+
+void Editor::updateWindow()
+{
+    m_windowUpdateQueued = false;
+    if (settingContent || m_blocks.isEmpty() || document()->blockCount() != m_windowCount)
+        return;
+
+    int firstVisible = firstVisibleBlockNumber();
+    int lastVisible = lastVisibleBlockNumber();
+    int windowEnd = m_windowFirst + m_windowCount;
+
+    // Paged before the viewport gets to an end of the window that isn't an
+    // end of the transcript, and shrunk once typing or pasting grew it
+    bool nearFirst = m_windowFirst > 0 && firstVisible - m_windowFirst < windowMargin / 2;
+    bool nearEnd = windowEnd < m_blocks.size() && windowEnd - 1 - lastVisible < windowMargin / 2;
+    bool tooLarge = m_windowCount > 4 * windowMargin + lastVisible - firstVisible;
+    if (nearFirst || nearEnd || tooLarge)
+        moveWindow(firstVisible - windowMargin, lastVisible + windowMargin + 1);
+}
+
+void Editor::updateBlockScrollBar()
+{
+    auto scrollBar = blockScrollBar();
+    if (!scrollBar)
+        return;
+
+    int firstVisible = firstVisibleBlockNumber();
+    int visibleCount = lastVisibleBlockNumber() - firstVisible + 1;
+
+    // Set from the view, it only scrolls it when the user moves it
+    const QSignalBlocker blocker(scrollBar);
+    scrollBar->setRange(0, qMax(0, totalBlockCount() - visibleCount));
+    scrollBar->setPageStep(visibleCount);
+    if (!scrollBar->isSliderDown())
+        scrollBar->setValue(firstVisible);
+}
+
+void Editor::scrollToBlock(int blockNumber)
+{
+    showBlock(blockNumber);
+    auto textBlock = findTextBlock(blockNumber);
+    if (textBlock.isValid())
+        verticalScrollBar()->setValue(textBlock.firstLineNumber());
+}
+
+bool Editor::findMatch(const QRegularExpression& expression, QTextDocument::FindFlags options)
+{
+    restoreCursor();
+    bool backward = options & QTextDocument::FindBackward;
+
+    // Without a selection the search starts at an end of the transcript
+    if (!textCursor().hasSelection())
+        showBlock(backward ? m_blocks.size() - 1 : 0);
+    if (TextEditor::findMatch(expression, options))
+        return true;
+
+    // Then goes on through the blocks that aren't paged in, matching like
+    // QTextDocument::find() does
+    auto lineExpression = expression;
+    if (options & QTextDocument::FindCaseSensitively)
+        lineExpression.setPatternOptions(lineExpression.patternOptions() & ~QRegularExpression::CaseInsensitiveOption);
+    else
+        lineExpression.setPatternOptions(lineExpression.patternOptions() | QRegularExpression::CaseInsensitiveOption);
+
+    QString line;
+    int step = backward ? -1 : 1;
+    for (int i = backward ? m_windowFirst - 1 : m_windowFirst + m_windowCount; i >= 0 && i < m_blocks.size(); i += step) {
+        line.resize(0);
+        appendBlockText(line, m_blocks[i]);
+
+        QRegularExpressionMatch match;
+        if (backward) {
+            auto matches = lineExpression.globalMatch(line);
+            while (matches.hasNext())
+                match = matches.next();
+        }
+        else
+            match = lineExpression.match(line);
+        if (!match.hasMatch() || !match.capturedLength())
+            continue;
+
+        auto cursor = blockCursor(i);
+        int start = cursor.position();
+        cursor.setPosition(start + match.capturedStart());
+        cursor.setPosition(start + match.capturedEnd(), QTextCursor::KeepAnchor);
+        setTextCursor(cursor);
+        return true;
+    }
+    return false;
+}
+
+void Editor::highlightOccurrences()
+{
+    QList<QTextEdit::ExtraSelection> selections;
+
+    // Only the visible occurrences are marked, scrolling marks the others
+    if (!m_statusKey.isEmpty() && m_wordIndex.count(m_statusKey) > 1) {
+        int firstVisible = firstVisibleBlockNumber();
+        int lastVisible = lastVisibleBlockNumber();
+
+        QTextCharFormat occurrenceFormat;
+        occurrenceFormat.setBackground(QColor(255, 240, 170));
+
+        for (auto& position: m_wordIndex.occurrences(m_statusKey, firstVisible, lastVisible)) {
+            auto textBlock = findTextBlock(position.block);
+            if (!textBlock.isValid())
+                continue;
+            auto text = textBlock.text();
+
+            WordTokenizer tokenizer(text, WordTokenizer::wordsStart(text));
+            WordSpan span;
+            bool wordFound = false;
+            for (int i = 0; i <= position.word && (wordFound = tokenizer.next(span)); i++) {}
+            if (!wordFound)
+                continue;
+
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(textBlock);
+            selection.cursor.setPosition(textBlock.position() + span.start);
+            selection.cursor.setPosition(textBlock.position() + span.start + span.text.size(), QTextCursor::KeepAnchor);
+            selection.format = occurrenceFormat;
+            selections.append(selection);
+        }
+    }
+
+    setOccurrenceSelections(selections);
+}
+
 void Editor::updateWordEditor()
 {
     if (!m_wordEditor || dontUpdateWordEditor)
         return;
     updatingWordEditor = true;
 
-    auto blockNumber = textCursor().blockNumber();
+    auto blockNumber = cursorBlockNumber();
 
     if (blockNumber >= m_blocks.size()) {
         m_wordEditor->clear();
         return;
     }
 
-    m_wordEditor->refreshWords(m_blocks[blockNumber].words);
+    m_wordEditor->refreshWords(m_blocks[blockNumber].words());
     updatingWordEditor = false;
 }
 
 void Editor::wordEditorChanged()
 {
-    auto editorBlockNumber = textCursor().blockNumber();
+    auto editorBlockNumber = cursorBlockNumber();
 
     if (document()->isEmpty() || m_blocks.isEmpty())
         m_blocks.append(fromEditor(0));
@@ -2606,24 +3195,13 @@ void Editor::wordEditorChanged()
     if (settingContent || updatingWordEditor || editorBlockNumber >= m_blocks.size())
         return;
 
-    auto& block = m_blocks[editorBlockNumber];
-    if (block.words.isEmpty()) {
-        block.words = m_wordEditor->currentWords();
-        return;
-    }
-
-    auto& words = block.words;
-    words.clear();
-
-    QString blockText;
-    words = m_wordEditor->currentWords();
-    for (auto& a_word: words)
-        blockText += a_word.text + " ";
-    block.text = blockText.trimmed();
+    // The line is rewritten from the edited words
+    auto editedBlock = m_blocks[editorBlockNumber];
+    editedBlock.setWords(m_wordEditor->currentWords());
 
     dontUpdateWordEditor = true;
-    setContent();
-    QTextCursor cursor(document()->findBlockByNumber(editorBlockNumber));
+    replaceBlocks(editorBlockNumber, 1, {editedBlock});
+    QTextCursor cursor = blockCursor(editorBlockNumber);
     setTextCursor(cursor);
     centerCursor();
     dontUpdateWordEditor = false;
@@ -2633,20 +3211,21 @@ void Editor::changeSpeaker(const QString& newSpeaker, bool replaceAllOccurrences
 {
     if (m_blocks.isEmpty())
         return;
-    auto blockNumber = textCursor().blockNumber();
+    auto blockNumber = cursorBlockNumber();
     auto blockSpeaker = m_blocks[blockNumber].speaker;
 
-    if (!replaceAllOccurrences)
-        m_blocks[blockNumber].speaker = newSpeaker;
-    else {
-        for (auto& a_block: m_blocks){
-            if (a_block.speaker == blockSpeaker)
-                a_block.speaker = newSpeaker;
-        }
+    auto speakerBlocks = replaceAllOccurrences ? m_speakerIndex.blocks(blockSpeaker) : QVector<int>{blockNumber};
+
+    // All the lines are renamed in one pass and one undo step
+    QVector<block> renamedBlocks;
+    renamedBlocks.reserve(speakerBlocks.size());
+    for (auto speakerBlock: speakerBlocks) {
+        renamedBlocks.append(m_blocks[speakerBlock]);
+        renamedBlocks.last().speaker = newSpeaker;
     }
+    replaceBlocks(speakerBlocks, renamedBlocks, "Change Speaker");
 
-    setContent();
-    QTextCursor cursor(document()->findBlockByNumber(blockNumber));
+    QTextCursor cursor = blockCursor(blockNumber);
     setTextCursor(cursor);
     centerCursor();
 
@@ -2663,35 +3242,27 @@ void Editor::propagateTime(const QTime& time, int start, int end, bool negateTim
         errorBox.exec();
         return;
     }
-    else if (start < 1 || end > blockCount() || start > end) {
+    else if (start < 1 || end > m_blocks.size() || start > end) {
         QMessageBox errorBox(QMessageBox::Critical, "Error", "Invalid Block Range Selected", QMessageBox::Ok);
         errorBox.exec();
         return;
     }
 
-    for (int i = start - 1; i < end; i++) {
-        auto& currentTimeStamp = m_blocks[i].timeStamp;
-
-        if (currentTimeStamp.isNull())
-            currentTimeStamp = QTime(0,0, 0, 0);
-
-        int secondsToAdd = time.hour() * 3600 + time.minute() * 60 + time.second();
-        int msecondsToAdd = time.msec();
-
-        if (negateTime) {
-            secondsToAdd = -secondsToAdd;
-            msecondsToAdd = -msecondsToAdd;
-        }
-
-        currentTimeStamp = currentTimeStamp.addMSecs(msecondsToAdd);
-        currentTimeStamp = currentTimeStamp.addSecs(secondsToAdd);
+    qint64 msecondsToAdd = TranscriptTime::fromTime(time);
+    if (negateTime)
+        msecondsToAdd = -msecondsToAdd;
 
+    // Timestamps don't wrap around midnight, they stop at the start of the media
+    auto shiftedBlocks = m_blocks.mid(start - 1, end - start + 1);
+    for (auto& shiftedBlock: shiftedBlocks) {
+        auto currentTime = shiftedBlock.hasTime() ? shiftedBlock.time : 0;
+        shiftedBlock.time = qMax<qint64>(0, currentTime + msecondsToAdd);
     }
 
-    int blockNumber = textCursor().blockNumber();
+    int blockNumber = cursorBlockNumber();
 
-    setContent();
-    QTextCursor cursor(document()->findBlockByNumber(blockNumber));
+    replaceBlocks(start - 1, shiftedBlocks.size(), shiftedBlocks);
+    QTextCursor cursor = blockCursor(blockNumber);
     setTextCursor(cursor);
     centerCursor();
 
@@ -2702,65 +3273,44 @@ void Editor::propagateTime(const QTime& time, int start, int end, bool negateTim
 
 void Editor::selectTags(const QStringList& newTagList)
 {
-    m_blocks[textCursor().blockNumber()].tagList = newTagList;
+    auto blockNumber = cursorBlockNumber();
+    auto taggedBlock = m_blocks[blockNumber];
+    taggedBlock.tagList = newTagList;
 
     emit refreshTagList(newTagList);
 
     // qInfo() << "[Tags Selected]"
     //         << "new tags: " << newTagList; // Disabled debug
-    setContent();
+    replaceBlocks(blockNumber, 1, {taggedBlock});
 
 }
 
 void Editor::markWordAsCorrect(int blockNumber, int wordNumber)
 {
-    auto textToInsert = m_blocks[blockNumber].words[wordNumber].text.toLower();
+    QString keyBuffer;
+    auto textToInsert = WordTokenizer::lowercase(WordTokenizer::strip(m_blocks[blockNumber].wordText(wordNumber), m_punctuation),
+                                                 keyBuffer).trimmed().toString();
 
-    if (textToInsert.trimmed() == "")
+    if (textToInsert == "")
         return;
 
-    if (isWordValid(textToInsert, m_dictionary, m_english_dictionary, m_transcriptLang)) {
+    if (BlockValidator::isWordValid(textToInsert, validationContext())) {
         emit message("Word is already correct.");
         return;
     }
 
-    m_dictionary.insert
-        (
-            std::upper_bound(m_dictionary.begin(), m_dictionary.end(), textToInsert),
-            textToInsert
-            );
-
-    static_cast<QStringListModel*>(m_textCompleter->model())->setStringList(m_dictionary);
-    m_correctedWords.insert(textToInsert);
-
-    QMultiMap<int, int> invalidWords;
-    for (int i = 0; i < m_blocks.size(); i++) {
-        //        qInfo()<<"\n \n m_blocks["<<i<<"].words : ";
-        for (int j = 0; j < m_blocks[i].words.size(); j++) {
-            auto wordText = m_blocks[i].words[j].text.toLower();
-
-            if (wordText != "" && m_punctuation.contains(wordText.back()))
-                wordText = wordText.left(wordText.size() - 1);
-
-            if (!isWordValid(wordText,
-                             m_dictionary,
-                             m_english_dictionary,
-                             m_transcriptLang)) {
-                invalidWords.insert(i, j);
-            }
-        }
-    }
-    m_highlighter->setInvalidWords(invalidWords);
-    m_highlighter->rehighlight();
+    // The word goes into the sorted overlay next to the shared table, so
+    // neither the dictionary nor its corrector are rebuilt. Every editor of
+    // the language revalidates its blocks holding the word in correctedWordAdded().
+    if (!DictionaryService::getInstance().addCorrectedWord(m_transcriptLang, textToInsert))
+        return;
 
     QFile correctedWords(QString("corrected_words_%1.txt").arg(m_transcriptLang));
 
-    if (!correctedWords.open(QFile::WriteOnly | QFile::Truncate))
+    if (!correctedWords.open(QFile::WriteOnly | QFile::Append))
         emit message("Couldn't write corrected words to file.");
-    else {
-        for (auto& a_word: m_correctedWords)
-            correctedWords.write(QString(a_word + "\n").toStdString().c_str());
-    }
+    else
+        correctedWords.write((textToInsert + "\n").toUtf8());
 
     // qInfo() << "[Mark As Correct]"
     //         << QString("text: %1").arg(textToInsert); // Disabled debug
@@ -2786,11 +3336,17 @@ void Editor::insertTextCompletion(const QString& completion)
 {
     if (m_textCompleter->widget() != this)
         return;
-    QTextCursor tc = textCursor();
-    int extra = completion.length() - m_textCompleter->completionPrefix().length();
+    // The model was filtered on the stripped word, so the completion continues
+    // it after its leading brackets or quotes and before its trailing marks
+    auto prefix = m_textCompleter->completionPrefix();
+    auto key = WordTokenizer::strip(prefix);
+    int extra = completion.length() - key.length();
+    int keyEnd = int(key.data() - prefix.constData()) + key.length();
 
-    tc.movePosition(QTextCursor::Left);
-    tc.movePosition(QTextCursor::EndOfWord);
+    QTextCursor tc = textCursor();
+    auto textTillCursor = tc.block().text().left(tc.positionInBlock());
+    int wordStart = textTillCursor.lastIndexOf(u' ') + 1;
+    tc.setPosition(tc.block().position() + wordStart + keyEnd);
     tc.insertText(completion.right(extra));
 
     setTextCursor(tc);
@@ -2857,10 +3413,10 @@ QList<QTime> Editor::getTimeStamps()
         return timeStamps;
     }
 
-    timeStamps.append(m_blocks[0].timeStamp);
+    timeStamps.append(m_blocks[0].timeStamp());
 
     for (int i = 1; i < m_blocks.size(); i++) {
-        timeStamps.append(std::as_const(m_blocks[i]).timeStamp);
+        timeStamps.append(std::as_const(m_blocks[i]).timeStamp());
     }
 
     return timeStamps;
@@ -2870,9 +3426,11 @@ void Editor::updateTimeStamp(int block_num, QTime endTime){
     if (m_blocks.empty() || block_num >= m_blocks.size() || block_num < 0)
         return;
     // if (block_num < m_blocks.size()) {
-    m_blocks[block_num].timeStamp = endTime;
-    m_blocks[block_num].words[m_blocks[block_num].words.size() - 1].timeStamp = endTime;
-    setContent();
+    auto stampedBlock = m_blocks[block_num];
+    stampedBlock.setTimeStamp(endTime);
+    if (stampedBlock.wordCount())
+        stampedBlock.setWordTime(stampedBlock.wordCount() - 1, TranscriptTime::fromTime(endTime));
+    replaceBlocks(block_num, 1, {stampedBlock});
     // } else if (block_num == m_blocks.size()) {
     //     struct block obj;
     //     obj.timeStamp = endTime;
@@ -2887,32 +3445,45 @@ void Editor::updateTimeStamp(int block_num, QTime endTime){
 
 void Editor::updateTimeStampsBlock(QVector<int> blks) {
 
-    for (int i = 0; i < m_blocks.size(); i++) {
-        QTime time(0,0,0);
-        time = time.addSecs(blks[i]);
-        m_blocks[i].timeStamp = time;
-        m_blocks[i].words[m_blocks[i].words.size() - 1].timeStamp = time;
-    }
-
+    // Only the lines whose time changed are rewritten, in one pass
+    QVector<int> stampedBlockNumbers;
+    QVector<block> stampedBlocks;
+    int existingBlocks = qMin(static_cast<int>(m_blocks.size()), static_cast<int>(blks.size()));
+    for (int i = 0; i < existingBlocks; i++) {
+        qint64 time = qint64(blks[i]) * 1000;
+        if (m_blocks[i].time == time
+            && (!m_blocks[i].wordCount() || m_blocks[i].wordTime(m_blocks[i].wordCount() - 1) == time))
+            continue;
+
+        auto stampedBlock = m_blocks[i];
+        stampedBlock.time = time;
+        if (stampedBlock.wordCount())
+            stampedBlock.setWordTime(stampedBlock.wordCount() - 1, time);
+        stampedBlockNumbers.append(i);
+        stampedBlocks.append(stampedBlock);
+    }
+
+    QVector<block> newBlocks;
     for (int i = m_blocks.size(); i < blks.size(); i++) {
 
-        QTime time(0,0,0);
-        time = time.addSecs(blks[i]);
-
-        word wrd;
-        wrd.timeStamp = time;
-        wrd.text = "";
+        qint64 time = qint64(blks[i]) * 1000;
 
         block bl;
         bl.speaker = "";
-        bl.text = "";
-        bl.words.append(wrd);
-        bl.timeStamp = time;
+        bl.appendWord(time, QStringView(), TagList(), false);
+        bl.time = time;
 
-        m_blocks.append(bl);
+        newBlocks.append(bl);
     }
 
-    setContent();
+    if (stampedBlocks.isEmpty() && newBlocks.isEmpty())
+        return;
+
+    // The stamped lines and the appended ones are a single undo step
+    m_undoStack->beginMacro("Update Time Stamps");
+    replaceBlocks(stampedBlockNumbers, stampedBlocks, "Update Time Stamps");
+    replaceBlocks(m_blocks.size(), 0, newBlocks);
+    m_undoStack->endMacro();
 }
 
 void Editor::showWaveform()
@@ -2924,7 +3495,7 @@ void Editor::showWaveform()
     QTime t;
     for(int i = 0; i < m_blocks.size(); ++i)
     {
-        t = m_blocks[i].timeStamp;
+        t = m_blocks[i].timeStamp();
         timevec.append(t);
     }
 
@@ -3,6 +3,14 @@
 #include "blockandword.h"
 #include "texteditor.h"
 #include "wordeditor.h"
+#include "wordlist.h"
+#include "blockvalidator.h"
+#include "completionmodel.h"
+#include "wordindex.h"
+#include "timeindex.h"
+#include "speakerindex.h"
+#include "blockeditcommand.h"
+#include "transcriptreader.h"
 #include "utilities/changespeakerdialog.h"
 #include "utilities/timepropagationdialog.h"
 #include "utilities/tagselectiondialog.h"
@@ -19,18 +27,40 @@
 #include <qmutex.h>
 #include <qrunnable.h>
 #include <qsemaphore.h>
-#include <set>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QTimer>
-#include <QUndoCommand>
+#include <QUndoStack>
 #include <QSettings>
+#include <QSet>
+#include <QFutureWatcher>
+#include <QBitArray>
+#include <QTextBlock>
 // #include <QQueue>
 
 class Highlighter;
 // class TaskRunner;
 
+/**
+ * @class BlockFlags
+ * @brief Highlighting state attached to a QTextBlock as its user data.
+ *
+ * The flags travel with the text block when lines are inserted or removed,
+ * and the word start offsets are refreshed in place on every highlight pass
+ * so their storage is reused. Blocks outside the highlight window keep their
+ * flags but are only formatted once they scroll into it.
+ */
+class BlockFlags : public QTextBlockUserData
+{
+public:
+    explicit BlockFlags(const BlockValidation& validation) : validation(validation) {}
+
+    BlockValidation validation; ///< Flags of the block and of its words.
+    QVector<int> wordStarts; ///< Offset of each word in the block text.
+    bool highlighted{false}; ///< The formats of the block reflect `validation`.
+};
+
 /**
  * @class Editor
  * @brief Manages the editing functionalities of transcripts, including
@@ -49,6 +79,11 @@ public:
      */
     explicit Editor(QWidget *parent = nullptr);
 
+    /**
+     * @brief Cancels a running background validation.
+     */
+    ~Editor() override;
+
     /**
      * @brief Sets the word editor for the current Editor instance.
      *
@@ -70,21 +105,17 @@ public:
      */
     void setEditorFont(const QFont& font);
 
-    QRegularExpression timeStampExp; ///< Regular expression for timestamps.
-    QRegularExpression speakerExp; ///< Regular expression for speaker identification.
-
-
     /**
      * @brief Configures the editor to move along timestamps.
      */
     void setMoveAlongTimeStamps();
 
     /**
-     * @brief Toggles the visibility of timestamps in the editor.
+     * @brief Toggles the visibility of the timestamp gutter.
      */
     void setShowTimeStamp();
 
-    QVector<block> m_blocks; ///< Stores the blocks of text and their associated data.
+    QVector<block> m_blocks; ///< Stores the blocks of text and their associated data, the document only holds a window of them.
     QUrl m_transcriptUrl; ///< URL of the loaded transcript.
     bool showTimeStamp=false; ///< Flag indicating whether to show timestamps.
 
@@ -97,6 +128,9 @@ public:
 
     /**
      * @brief Sets the content of the editor.
+     *
+     * Only the first blocks of `m_blocks` are put in the document, the rest
+     * is paged in as the view moves (see `moveWindow()`).
      */
     void setContent();
 
@@ -117,11 +151,42 @@ public:
      */
     QList<QTime> getTimeStamps();
 
+    /**
+     * @brief Returns the index of the block and word timestamps, kept in sync
+     *        with `m_blocks`.
+     */
+    const TimeIndex& timeIndex() const { return m_timeIndex; }
+
+    /**
+     * @brief Replaces every match of `expression` in the block texts, working
+     *        on `m_blocks` in one pass.
+     *
+     * Words stay aligned with their timestamps and tags: a word whose matches
+     * stay inside it is edited in place, otherwise the words of the block are
+     * reconciled like a typed edit. Only the changed lines are rewritten, as
+     * one undoable edit. Speakers aren't searched.
+     *
+     * @return The number of replaced matches.
+     */
+    int replaceAll(const QRegularExpression& expression, const QString& replacement, bool expandGroups) override;
+
+    /**
+     * @brief Finds `expression` in the document, then in the blocks of
+     *        `m_blocks` past it, whose line is paged in to select the match.
+     */
+    bool findMatch(const QRegularExpression& expression, QTextDocument::FindFlags options = {}) override;
+
     friend class Highlighter; ///< Grants Highlighter access to private members.
+    friend class BlockEditCommand; ///< Grants BlockEditCommand access to `applyBlocks()`.
+    friend class BlockBatchCommand; ///< Grants BlockBatchCommand access to `applyBlocks()`.
 
     /**
      * @brief Loads transcript data from a given URL.
      *
+     * The file is parsed on a worker thread and its lines are shown as they
+     * arrive, the first screen is editable before the rest is read. Opening
+     * another file meanwhile cancels the load.
+     *
      * @param fileUrl Pointer to the QUrl containing the transcript URL.
      */
     void loadTranscriptFromUrl(QUrl* fileUrl);
@@ -134,7 +199,6 @@ public:
      */
     void showWaveform();
 
-    //    QUndoStack *undoStack=nullptr;
 protected:
 
     /**
@@ -178,6 +242,27 @@ protected:
      */
     void contextMenuEvent(QContextMenuEvent *event) override;
 
+    /**
+     * @brief Pastes or drops text, marking the edit so that `contentChanged()`
+     *        reads the timestamps exported at the end of the pasted lines.
+     */
+    void insertFromMimeData(const QMimeData *source) override;
+
+    /**
+     * @brief Returns the timestamp of block `blockNumber` for the timestamp gutter.
+     */
+    QString blockTimeStamp(int blockNumber) const override;
+
+    /**
+     * @brief Returns the block of `m_blocks` shown on the first line of the document.
+     */
+    int firstBlockNumber() const override { return m_windowFirst; }
+
+    /**
+     * @brief Returns the number of blocks of the transcript, in the document or not.
+     */
+    int totalBlockCount() const override { return m_blocks.isEmpty() ? blockCount() : m_blocks.size(); }
+
 signals:
 
     /**
@@ -220,8 +305,25 @@ signals:
      */
     void sendBlockText(QString blockText);
 
+    /**
+     * @brief Signal emitted while a transcript loads.
+     *
+     * @param percent Percentage of the file read, 100 once the load ended.
+     */
+    void loadProgress(int percent);
+
 public slots:
 
+    /**
+     * @brief Undoes the last transcript edit, typed or made by a model operation.
+     */
+    void undo();
+
+    /**
+     * @brief Redoes the last undone transcript edit.
+     */
+    void redo();
+
     /**
      * @brief Opens a transcript file, allowing the user to select a file from the file dialog.
      *
@@ -270,8 +372,9 @@ public slots:
     /**
      * @brief Opens a file dialog to add a custom dictionary.
      *
-     * Opens a dialog to select a custom dictionary file (in .txt format). Sets the path and loads
-     * the dictionary if the file is successfully opened.
+     * Opens a dialog to select a custom dictionary file (in .txt format). Sets the path and merges
+     * its words into the dictionary of the transcript language once that is loaded, see
+     * `mergeCustomDictionary()`.
      */
     void addCustomDictonary();
 
@@ -440,6 +543,12 @@ private slots:
     void contentChanged(int position, int charsRemoved, int charsAdded);
     void wordEditorChanged();
 
+    /**
+     * @brief Asks for a new timestamp of block `blockNumber`, after its
+     *        timestamp was double clicked in the gutter.
+     */
+    void editTimeStamp(int blockNumber);
+
     /**
      * @brief Updates the word editor with the current block's words.
      *
@@ -552,18 +661,6 @@ private slots:
 
 private:
 
-    /**
-     * @brief Parses a time string and converts it into a QTime object.
-     *
-     * The function checks the format of the provided time string `text` to determine
-     * whether it includes fractional seconds ('.') and whether it has hours included (based on the number of colons).
-     * Based on these characteristics, it applies the appropriate format for parsing.
-     *
-     * @param text A QString containing the time string to be converted.
-     * @return A QTime object representing the parsed time, or an invalid QTime if parsing fails.
-     */
-    static QTime getTime(const QString& text);
-
     /**
      * @brief Creates a word object with the given attributes.
      *
@@ -572,11 +669,11 @@ private:
      *
      * @param t The QTime representing the timestamp of the word.
      * @param s The QString representing the content of the word.
-     * @param tagList A QStringList containing any tags associated with the word.
-     * @param isEdited A QString indicating the edit status of the word.
+     * @param tagList The tags associated with the word.
+     * @param isEdited Whether the word was edited by the annotator.
      * @return A `word` struct initialized with the provided parameters.
      */
-    static word makeWord(const QTime& t, const QString& s, const QStringList& tagList, const QString& isEdited);
+    static word makeWord(const QTime& t, const QString& s, const TagList& tagList, bool isEdited);
 
     /**
      * @brief Creates and configures a QCompleter for use in the editor.
@@ -589,16 +686,35 @@ private:
     QCompleter* makeCompleter();
 
     /**
-     * @brief Saves the current transcript data to an XML file.
+     * @brief Saves a snapshot of `m_blocks` to `fileName` on a worker thread.
      *
-     * This function writes the contents of `m_blocks` to an XML file, with each block
-     * represented as a "line" element containing a timestamp, speaker, and a list of words.
-     * Words within each line are nested as "word" elements with associated timestamps, tags,
-     * and edit status.
+     * The file is replaced atomically once the XML is written and synced. On
+     * success the snapshot's revision is marked saved and the save latency is
+     * shown in the status bar. Only one save runs at a time, a save requested
+     * meanwhile is queued and runs once it finishes.
+     */
+    void saveTranscript(const QString& fileName);
+
+    /**
+     * @brief Runs `alignTranscript()` on a worker thread, or queues one run
+     *        behind the running one.
+     */
+    void startAlignment();
+
+    /**
+     * @brief Writes the text of `blocks` to `fileAfterSave` and runs the
+     *        alignment script comparing it with `fileBeforeSave`, run on a
+     *        worker thread.
      *
-     * @param file A pointer to the QFile where the XML content will be written.
+     * @param runAligner Whether to run the script, or only write the text.
+     * @return The error, empty on success.
+     */
+    static QString alignTranscript(QVector<block> blocks, QString fileBeforeSave, QString fileAfterSave, bool runAligner);
+
+    /**
+     * @brief Checks whether the transcript changed since it was loaded or saved.
      */
-    void saveXml(QFile* file);
+    bool isModified() const { return m_revision != m_savedRevision; }
 
     /**
      * @brief Sends the current text block to the \c MediaPlayer, allowing a jump to the relevant timestamp with \c MediaPlayer::setPositionToTime.
@@ -619,19 +735,63 @@ private:
      */
     void loadDictionary();
 
+    /**
+     * @brief Picks up a dictionary loaded or updated by the `DictionaryService`.
+     *
+     * The blocks are re-validated if it is the dictionary of the transcript
+     * language, or the English one used as a fallback.
+     *
+     * @param language Language of the dictionary.
+     * @param words The shared dictionary.
+     */
+    void dictionaryReady(const QString& language, const WordList& words);
+
+    /**
+     * @brief Merges the words of `m_customDictionaryWords` into `dictionary`
+     *        and saves the custom merge of `language` on a worker thread.
+     *
+     * The merged dictionary replaces the shared one once it is saved.
+     */
+    void mergeCustomDictionary(const QString& language, const WordList& dictionary);
+
+    /**
+     * @brief Revalidates the blocks holding a word marked correct, in this
+     *        editor or another one of the same language.
+     */
+    void correctedWordAdded(const QString& language, const QString& word);
+
     /**
      * @brief Converts a block number into a block structure containing the timestamp,
      *        text, speaker, and a list of words.
      *
-     * This method processes the block text to extract a timestamp, speaker, and the
-     * corresponding text. It uses regular expressions to match the timestamp and speaker
-     * formats, and splits the text accordingly. The extracted words are stored in a
-     * QVector of word structures.
+     * This method processes the block text to extract the speaker and the
+     * corresponding text, and splits the text into words. Timestamps are drawn
+     * in the gutter, so a line normally has none.
      *
-     * @param blockNumber The block number to convert into a block structure.
+     * @param blockNumber The number of the line in the document, not in `m_blocks`.
+     * @param parseTimeStamp Also strip a trailing `{hh:mm:ss.zzz}` from the
+     *        text and use it as the timestamp, for lines pasted from an export.
      * @return block A block structure containing the extracted data.
      */
-    block fromEditor(qint64 blockNumber) const;
+    block fromEditor(qint64 blockNumber, bool parseTimeStamp = false) const;
+
+    /**
+     * @brief Splits a line into its speaker and its trimmed text, as
+     *        `fromEditor()` reads them.
+     */
+    static void parseLine(QStringView line, QStringView& speaker, QStringView& text);
+
+    /**
+     * @brief Checks whether `line` reads as `a_block`, ignoring the spaces
+     *        `fromEditor()` trims.
+     */
+    static bool lineMatchesBlock(QStringView line, const block& a_block);
+
+    /**
+     * @brief Rewrites the lines `blockNumbers` from `m_blocks` on the next
+     *        event loop turn, once pasted timestamps were taken out of them.
+     */
+    void stripPastedTimeStamps(const QVector<int>& blockNumbers);
 
     /**
      * @brief Loads transcript data from an XML file into the editor.
@@ -647,8 +807,43 @@ private:
      */
     static QStringList listFromFile(const QString& fileName) ;
 
+    /**
+     * @brief Draws the playback position as an overlay on the highlighted block.
+     *
+     * The current line and word are rendered through extra selections, so a
+     * playback tick only repaints the affected rectangles instead of running
+     * the syntax highlighter over the document.
+     */
+    void updatePlaybackHighlight();
+
+    /**
+     * @brief Returns the number of the word under the text cursor, or -1.
+     */
+    int wordNumberAtCursor() const;
+
+    /**
+     * @brief Checks whether a word was flagged as not found in the dictionaries.
+     */
+    bool isWordFlaggedInvalid(int blockNumber, int wordNumber) const;
+
+    /**
+     * @brief Returns spelling corrections for a word, from the transcript
+     *        language and then from English.
+     *
+     * Empty while the correctors are still being built.
+     */
+    QStringList spellingSuggestions(const QString& wordText) const;
+
+    /**
+     * @brief Shows the number of occurrences of the word under the cursor in
+     *        the status bar, with corrections if it is misspelled, and
+     *        highlights its other occurrences.
+     */
+    void showWordStatus();
+
     // State flags
     bool settingContent{false}; ///< Indicates if the editor is currently in a setting content mode.
+    bool m_pasting{false}; ///< Text is being pasted or dropped, see `insertFromMimeData()`.
     bool updatingWordEditor{false}; ///< Indicates if the word editor is being updated.
     bool dontUpdateWordEditor{false}; ///< Flag to prevent updates to the word editor.
 
@@ -678,12 +873,16 @@ private:
     QCompleter *m_speakerCompleter = nullptr; ///< Completer for speaker names.
     QCompleter *m_textCompleter = nullptr; ///< Completer for text suggestions.
     QCompleter *m_transliterationCompleter = nullptr; ///< Completer for transliteration suggestions.
+    CompletionTrie m_transcriptWords; ///< Normalized words of the transcript with their occurrences.
+    CompletionModel* m_completionModel = nullptr; ///< Model of `m_textCompleter`.
 
     // Dictionaries
-    QStringList m_dictionary; ///< List of user-defined dictionary entries.
-    QStringList m_english_dictionary; ///< List of English dictionary entries.
+    WordList m_dictionary; ///< Dictionary of the transcript language, with custom and corrected words.
+    WordList m_english_dictionary; ///< English dictionary, also accepted in other languages.
+    QString m_heldLanguage; ///< Language held in the `DictionaryService`, besides English.
     QString m_customDictonaryPath = nullptr; ///< Path to the custom dictionary file.
-    std::set<QString> m_correctedWords; ///< Set of words that have been corrected.
+    QString m_customDictionaryLanguage; ///< Language `m_customDictionaryWords` are merged into.
+    QStringList m_customDictionaryWords; ///< Custom words waiting for their dictionary to load.
     QString m_transliterateLangCode; ///< Language code for transliteration.
 
     // Network management
@@ -713,10 +912,261 @@ private:
     // const int debounceDelay = 300;
 
 private:
-    bool isWordValid(const QString& wordText,
-                     const QStringList& primaryDict,
-                     const QStringList& englishDict,
-                     const QString& transcriptLang);
+    /**
+     * @brief Snapshots the dictionaries and settings used to validate blocks.
+     */
+    ValidationContext validationContext() const;
+
+    /**
+     * @brief Re-validates the blocks in the range [first, last] and stores the
+     *        results in `m_blockValidation`.
+     */
+    void revalidateBlocks(int first, int last);
+
+    /**
+     * @brief Starts validating every block on a worker thread.
+     *
+     * The worker gets a snapshot of `m_blocks` and the dictionaries, and
+     * reports results in chunks, visible blocks first. Starting again cancels
+     * the previous run, whose results are dropped by their generation.
+     */
+    void startValidation();
+
+    /**
+     * @brief Applies the chunks reported by the worker in [begin, end).
+     */
+    void applyValidationResults(int begin, int end);
+
+    /**
+     * @brief Attaches the cached validation state of the blocks in the range
+     *        [first, last] to their text blocks.
+     *
+     * Only blocks whose flags changed are rehighlighted. A negative `last`
+     * means up to the final block.
+     */
+    void applyValidation(int first = 0, int last = -1);
+
+    /**
+     * @brief Adds the words of block `blockNumber` to `m_wordIndex` and
+     *        `m_transcriptWords`, and its speaker to `m_speakerIndex`.
+     */
+    void indexBlock(int blockNumber);
+
+    /**
+     * @brief Removes block `blockNumber` from `m_wordIndex`, `m_transcriptWords`
+     *        and `m_speakerIndex`, before the block is edited or removed.
+     */
+    void unindexBlock(int blockNumber);
+
+    /**
+     * @brief Rebuilds `m_wordIndex`, `m_transcriptWords` and `m_speakerIndex`
+     *        from `m_blocks`.
+     */
+    void rebuildIndexes();
+
+    /**
+     * @brief Appends the line shown for `a_block`, without a line break, to `text`.
+     */
+    void appendBlockText(QString& text, const block& a_block) const;
+
+    /**
+     * @brief Replaces `count` blocks of `m_blocks` starting at `first` with
+     *        `blocks`, without touching the document.
+     *
+     * The blocks are spliced in once, only the affected entries of the
+     * indexes are updated and only the new blocks are re-validated. The
+     * caller attaches their validation once the document lines exist.
+     */
+    void spliceBlocks(int first, int count, const QVector<block>& blocks);
+
+    /**
+     * @brief Returns `blockFromData` updated with the speaker, text and words
+     *        of the edited line `blockFromEditor`.
+     *
+     * Words that are still there keep their timestamp, tags and edited flag.
+     */
+    block mergeEditedBlock(const block& blockFromData, block blockFromEditor) const;
+
+    /**
+     * @brief Returns `a_block` with the matches of `expression` in its text
+     *        replaced, and adds their number to `replacementCount`.
+     */
+    block replaceInBlock(const block& a_block, const QRegularExpression& expression,
+                         const QString& replacement, bool expandGroups, int& replacementCount) const;
+
+    /**
+     * @brief Replaces `count` blocks of `m_blocks` starting at `first` with
+     *        `blocks`, as an undoable step on `m_undoStack`.
+     */
+    void replaceBlocks(int first, int count, const QVector<block>& blocks);
+
+    /**
+     * @brief Replaces the blocks `blockNumbers`, in increasing order, with
+     *        `blocks` one for one, as a single undoable step named `text`.
+     */
+    void replaceBlocks(const QVector<int>& blockNumbers, const QVector<block>& blocks, const QString& text);
+
+    /**
+     * @brief Replaces `count` blocks of `m_blocks` starting at `first` with
+     *        `blocks` and applies the change to the document.
+     *
+     * Only the affected lines of the document are rewritten, with cursor edits
+     * grouped in one edit block, and only the affected entries of the indexes
+     * and of the validation cache are updated. Model operations use this
+     * instead of `setContent()`, so they cost O(changed lines).
+     */
+    void applyBlocks(int first, int count, const QVector<block>& blocks);
+
+    /**
+     * @brief Replaces the blocks `blockNumbers` with `blocks` one for one and
+     *        applies the change to the document.
+     *
+     * The lines are rewritten in one edit block, the time index is updated
+     * once from the first of them, and the playback, occurrence and timestamp
+     * highlights are refreshed once at the end.
+     */
+    void applyBlocks(const QVector<int>& blockNumbers, const QVector<block>& blocks);
+
+    /**
+     * @brief Shows the chunks of the running load reported in [begin, end).
+     */
+    void applyLoadedChunks(int begin, int end);
+
+    /**
+     * @brief Appends loaded blocks to `m_blocks` and their lines to the
+     *        document, without re-validating them.
+     */
+    void appendLoadedBlocks(const QVector<block>& blocks);
+
+    /**
+     * @brief Validates the loaded transcript, writes `fileBeforeSave` and
+     *        restarts auto-saving.
+     *
+     * @param errorString Error of the load, empty on success.
+     */
+    void finishLoading(const QString& errorString);
+
+    /**
+     * @brief Highlights the occurrences of `m_statusKey` in the visible blocks.
+     */
+    void highlightOccurrences();
+
+    /**
+     * @brief Moves the highlight window of `m_highlighter` around the viewport.
+     *
+     * The highlighter works on document lines, the window is a part of the
+     * lines paged in by `moveWindow()`.
+     */
+    void updateHighlightWindow();
+
+    /**
+     * @brief Returns the line showing block `blockNumber` of `m_blocks`,
+     *        invalid when the block isn't paged in.
+     */
+    QTextBlock findTextBlock(int blockNumber) const;
+
+    /**
+     * @brief Returns the block of `m_blocks` the text cursor is on, also
+     *        while its line is paged out.
+     */
+    int cursorBlockNumber() const;
+
+    /**
+     * @brief Returns the blocks of `m_blocks` on the first and last visible lines.
+     */
+    int firstVisibleBlockNumber() const;
+    int lastVisibleBlockNumber() const;
+
+    /**
+     * @brief Returns the lines of the blocks in [first, end), separated by line breaks.
+     */
+    QString windowText(int first, int end) const;
+
+    /**
+     * @brief Pages the blocks [first, end) of `m_blocks` in the document,
+     *        removing the others.
+     *
+     * The lines kept are left alone, the others are removed or added at the
+     * ends of the document, or all of it is rewritten with `rewrite`. The
+     * view stays on the same block. The cursor is parked while its line is
+     * out and put back once it is paged in again.
+     */
+    void moveWindow(int first, int end, bool rewrite = false);
+
+    /**
+     * @brief Pages in block `blockNumber` with `windowMargin` blocks around
+     *        it, unless it is already in the document.
+     */
+    void showBlock(int blockNumber);
+
+    /**
+     * @brief Returns a cursor at the start of block `blockNumber`, paged in first.
+     */
+    QTextCursor blockCursor(int blockNumber);
+
+    /**
+     * @brief Pages in the line of a parked cursor and shows it, before the
+     *        cursor is used.
+     */
+    void restoreCursor();
+
+    /**
+     * @brief Runs `updateWindow()` once on the next event loop turn.
+     */
+    void scheduleWindowUpdate();
+
+    /**
+     * @brief Moves the window when the viewport gets near one of its ends,
+     *        or shrinks it when it grew by typing.
+     */
+    void updateWindow();
+
+    /**
+     * @brief Sets the range and position of the block scroll bar from the
+     *        viewport, in blocks of the whole transcript.
+     */
+    void updateBlockScrollBar();
+
+    /**
+     * @brief Scrolls to block `blockNumber`, from the block scroll bar.
+     */
+    void scrollToBlock(int blockNumber);
+
+    static constexpr int highlightWindowMargin = 100; ///< Blocks formatted above and below the viewport.
+    static constexpr int windowMargin = 500; ///< Blocks paged in above and below the viewport.
+
+    QUndoStack* m_undoStack{nullptr}; ///< Edits of `m_blocks`, the document keeps no undo history of its own.
+    WordIndex m_wordIndex; ///< Positions of the normalized words of `m_blocks`.
+    TimeIndex m_timeIndex; ///< Timestamps of `m_blocks`.
+    SpeakerIndex m_speakerIndex; ///< Speakers of `m_blocks`.
+    quint64 m_completedSpeakersRevision{0}; ///< Revision of `m_speakerIndex` in the speaker completer.
+
+    QVector<BlockValidation> m_blockValidation; ///< Cached validation results, parallel to `m_blocks`.
+    QFutureWatcher<ValidationChunk> m_validationWatcher; ///< Watches the background validation.
+    quint64 m_validationGeneration{0}; ///< Generation of the latest background validation.
+    QSet<int> m_locallyValidated; ///< Blocks re-validated after an edit during the running validation.
+
+    QFutureWatcher<TranscriptChunk> m_loadWatcher; ///< Watches the background transcript load.
+    quint64 m_loadGeneration{0}; ///< Generation of the latest transcript load.
+    bool m_loading{false}; ///< A transcript is being loaded, `m_blocks` only holds its first lines.
+
+    quint64 m_revision{0}; ///< Incremented on every change of `m_blocks` or of the transcript language.
+    quint64 m_savedRevision{0}; ///< Revision of the last load or completed save.
+    bool m_saving{false}; ///< A save is running on a worker thread.
+    QString m_queuedSave; ///< File of the save to run after the current one, empty for none.
+    bool m_aligning{false}; ///< The alignment script is running on a worker thread.
+    bool m_alignmentQueued{false}; ///< Another alignment was requested while it runs.
+
+    int m_windowFirst{0}; ///< Block of `m_blocks` on the first line of the document.
+    int m_windowCount{0}; ///< Number of blocks of `m_blocks` in the document.
+    int m_parkedBlock{-1}; ///< Block of the cursor while its line is paged out, -1 if it isn't.
+    int m_parkedPosition{0}; ///< Position of the parked cursor in its line.
+    bool m_windowUpdateQueued{false}; ///< `updateWindow()` runs on the next event loop turn.
+
+    int m_statusBlock{-1}; ///< Block of the word shown in the status bar.
+    int m_statusWord{-1}; ///< Word shown in the status bar.
+    QString m_statusKey; ///< Normalized word shown in the status bar, its occurrences are highlighted.
+    bool m_showingWordStatus{false}; ///< The word status is shown in the status bar.
 
 
 public:
@@ -735,67 +1185,57 @@ class Highlighter : public QSyntaxHighlighter
 {
     Q_OBJECT
 public:
-    explicit Highlighter(QTextDocument *parent = nullptr) : QSyntaxHighlighter(parent) {};
+    explicit Highlighter(QTextDocument *parent = nullptr);
 
-    void clearHighlight()
-    {
-        blockToHighlight = -1;
-        wordToHighlight = -1;
-    }
-    void setBlockToHighlight(qint64 blockNumber)
-    {
-        blockToHighlight = blockNumber;
-        rehighlight();
-    }
-    void setWordToHighlight(int wordNumber)
-    {
-        wordToHighlight = wordNumber;
-        rehighlight();
-    }
-    void setInvalidBlocks(const QList<int>& invalidBlocks)
-    {
-        invalidBlockNumbers = invalidBlocks;
-        rehighlight();
-    }
-    void setTaggedBlocks(const QList<int>& taggedBlock)
-    {
-        taggedBlockNumbers = taggedBlock;
-        rehighlight();
-    }
-    void clearTaggedBlocks()
-    {
-        taggedBlockNumbers.clear();
-    }
-    void setInvalidWords(const QMultiMap<int, int>& invalidWordsMap)
-    {
-        invalidWords = invalidWordsMap;
-        rehighlight();
-    }
-    void setTaggedWords(const QMultiMap<int, int>& taggedWordsMap)
-    {
-        taggedWords = taggedWordsMap;
-        rehighlight();
-    }
-    void setEditedWords(const QMultiMap<int, int>& editedWordsMap) {
-        editedWords = editedWordsMap;
-        rehighlight();
-    }
-    void clearInvalidBlocks()
-    {
-        invalidBlockNumbers.clear();
-    }
+    /**
+     * @brief Attaches the validation state of a block to its text block.
+     *
+     * The block is scheduled for rehighlighting only when its flags changed.
+     *
+     * @param textBlock Text block the state belongs to.
+     * @param validation Validation state of the block.
+     */
+    void setBlockValidation(QTextBlock textBlock, const BlockValidation& validation);
+
+    /**
+     * @brief Queues a block for rehighlighting on the next event loop turn.
+     *
+     * All blocks scheduled during one turn are rehighlighted together by
+     * `rehighlightScheduledBlocks()`.
+     */
+    void scheduleRehighlight(int blockNumber);
+
+    /**
+     * @brief Restricts formatting to the blocks in [first, last], around the viewport.
+     *
+     * Blocks outside the window are left unformatted, and the blocks entering
+     * it whose flags were never applied are scheduled for rehighlighting, so
+     * opening or revalidating a long transcript only formats what is shown.
+     */
+    void setWindow(int first, int last);
 
     void highlightBlock(const QString&) override;
 
+signals:
+    /**
+     * @brief Emitted after a batch of scheduled blocks was rehighlighted.
+     *
+     * @param blockCount Number of blocks that were re-shaped in this batch.
+     */
+    void blocksRehighlighted(int blockCount);
+
+private slots:
+    void rehighlightScheduledBlocks();
+
 private:
-    int blockToHighlight{-1};
-    int wordToHighlight{-1};
-    QList<int> invalidBlockNumbers;
-    QList<int> taggedBlockNumbers;
-
-    QMultiMap<int, int> invalidWords;
-    QMultiMap<int, int> taggedWords;
-    QMultiMap<int, int> editedWords;
+    QTextCharFormat invalidBlockFormat;
+    QTextCharFormat taggedBlockFormat;
+    QTextCharFormat wordFormats[8]; ///< Word formats indexed by the invalid, tagged and edited bits.
+
+    QSet<int> scheduledBlocks;
+    bool rehighlightQueued{false};
+    int windowFirst{0}; ///< First block of the highlight window.
+    int windowLast{-1}; ///< Last block of the highlight window.
 };
 
 // class TaskRunner : public QRunnable {
@@ -0,0 +1,104 @@
+#include "speakerindex.h"
+
+#include <algorithm>
+
+void SpeakerIndex::clear()
+{
+    m_names.clear();
+    m_ids.clear();
+    m_blocks.clear();
+    m_revision++;
+}
+
+QString SpeakerIndex::add(int blockNumber, const QString& speaker)
+{
+    auto found = m_ids.constFind(speaker);
+    int id;
+    if (found == m_ids.cend()) {
+        id = m_names.size();
+        m_names.append(speaker);
+        m_ids.insert(speaker, id);
+        m_blocks.append(QVector<int>());
+    }
+    else
+        id = *found;
+
+    auto& blocks = m_blocks[id];
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), blockNumber);
+    if (it == blocks.end() || *it != blockNumber) {
+        blocks.insert(it, blockNumber);
+        if (blocks.size() == 1)
+            m_revision++;
+    }
+
+    return m_names[id];
+}
+
+void SpeakerIndex::remove(int blockNumber, const QString& speaker)
+{
+    auto found = m_ids.constFind(speaker);
+    if (found == m_ids.cend())
+        return;
+
+    auto& blocks = m_blocks[*found];
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), blockNumber);
+    if (it != blocks.end() && *it == blockNumber) {
+        blocks.erase(it);
+        if (blocks.isEmpty())
+            m_revision++;
+    }
+}
+
+void SpeakerIndex::insertBlocks(int blockNumber, int count)
+{
+    for (auto& blocks: m_blocks) {
+        for (auto it = std::lower_bound(blocks.begin(), blocks.end(), blockNumber); it != blocks.end(); ++it)
+            *it += count;
+    }
+}
+
+void SpeakerIndex::removeBlocks(int blockNumber, int count)
+{
+    for (auto& blocks: m_blocks) {
+        for (auto it = std::lower_bound(blocks.begin(), blocks.end(), blockNumber + count); it != blocks.end(); ++it)
+            *it -= count;
+    }
+}
+
+QStringList SpeakerIndex::speakers() const
+{
+    QStringList speakers;
+    for (int id = 0; id < m_names.size(); id++) {
+        if (!m_names[id].isEmpty() && !m_blocks[id].isEmpty())
+            speakers.append(m_names[id]);
+    }
+    return speakers;
+}
+
+QVector<int> SpeakerIndex::blocks(const QString& speaker) const
+{
+    auto found = m_ids.constFind(speaker);
+    return found == m_ids.cend() ? QVector<int>() : m_blocks[*found];
+}
+
+int SpeakerIndex::previousBlock(const QString& speaker, int blockNumber) const
+{
+    auto found = m_ids.constFind(speaker);
+    if (found == m_ids.cend())
+        return -1;
+
+    auto& blocks = m_blocks[*found];
+    auto it = std::lower_bound(blocks.cbegin(), blocks.cend(), blockNumber);
+    return it == blocks.cbegin() ? -1 : *(it - 1);
+}
+
+int SpeakerIndex::nextBlock(const QString& speaker, int blockNumber) const
+{
+    auto found = m_ids.constFind(speaker);
+    if (found == m_ids.cend())
+        return -1;
+
+    auto& blocks = m_blocks[*found];
+    auto it = std::upper_bound(blocks.cbegin(), blocks.cend(), blockNumber);
+    return it == blocks.cend() ? -1 : *it;
+}
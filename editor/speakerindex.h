@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class SpeakerIndex
+ * @brief Interned table of the speakers of a transcript with the sorted
+ *        numbers of the blocks each one speaks.
+ *
+ * Speakers get an id the first time they are seen and keep it, so the table
+ * only grows while a transcript is open. Block lists are updated as blocks
+ * are edited, inserted or removed, which keeps the speaker list for completion
+ * and the previous/next turn of a speaker available without a scan.
+ */
+class SpeakerIndex
+{
+public:
+    void clear();
+
+    /**
+     * @brief Records that block `blockNumber` is spoken by `speaker`.
+     *
+     * @return The interned speaker name, to be shared by the block.
+     */
+    QString add(int blockNumber, const QString& speaker);
+
+    /**
+     * @brief Forgets that block `blockNumber` is spoken by `speaker`.
+     */
+    void remove(int blockNumber, const QString& speaker);
+
+    /**
+     * @brief Shifts the blocks `blockNumber` and after by `count`, to make room
+     *        for inserted blocks.
+     */
+    void insertBlocks(int blockNumber, int count);
+
+    /**
+     * @brief Shifts the blocks after the removed blocks [blockNumber,
+     *        blockNumber + count) back. They must be removed first.
+     */
+    void removeBlocks(int blockNumber, int count);
+
+    /**
+     * @brief Returns the named speakers that speak at least one block, in the
+     *        order they were first seen.
+     */
+    QStringList speakers() const;
+
+    /**
+     * @brief Returns a number that changes whenever `speakers()` does.
+     */
+    quint64 revision() const { return m_revision; }
+
+    /**
+     * @brief Returns the blocks spoken by `speaker`, in order.
+     */
+    QVector<int> blocks(const QString& speaker) const;
+
+    /**
+     * @brief Returns the last block before `blockNumber` spoken by `speaker`, or -1.
+     */
+    int previousBlock(const QString& speaker, int blockNumber) const;
+
+    /**
+     * @brief Returns the first block after `blockNumber` spoken by `speaker`, or -1.
+     */
+    int nextBlock(const QString& speaker, int blockNumber) const;
+
+private:
+    QStringList m_names; ///< Speaker names by id.
+    QHash<QString, int> m_ids; ///< Speaker ids by name.
+    QVector<QVector<int>> m_blocks; ///< Sorted block numbers by speaker id.
+    quint64 m_revision{0};
+};
@@ -0,0 +1,142 @@
+#include "spellingcorrector.h"
+
+#include <QHash>
+#include <QVarLengthArray>
+#include <algorithm>
+
+template<typename Callback>
+void SpellingCorrector::forEachDelete(QStringView prefix, Callback callback)
+{
+    // Each round deletes one more character from the strings of the previous
+    // one, repeated letters give the same string more than once
+    QVarLengthArray<QString, 32> deletes;
+    deletes.append(prefix.toString());
+    qsizetype roundStart = 0;
+    for (int distance = 1; distance <= maxDistance; distance++) {
+        auto roundEnd = deletes.size();
+        for (auto i = roundStart; i < roundEnd; i++) {
+            auto source = deletes[i];
+            for (qsizetype k = 0; k < source.size(); k++) {
+                auto deleted = source;
+                deleted.remove(k, 1);
+                if (std::find(deletes.begin() + roundEnd, deletes.end(), deleted) == deletes.end())
+                    deletes.append(deleted);
+            }
+        }
+        roundStart = roundEnd;
+    }
+
+    for (auto& variant: std::as_const(deletes))
+        callback(QStringView(variant));
+}
+
+SpellingCorrector::SpellingCorrector(const WordList& words)
+    : m_words(words)
+{
+    // 1 + 7 + 21 strings for a full prefix of 7 characters
+    qsizetype entriesPerWord = 0, choices = 1;
+    for (int distance = 0; distance <= maxDistance; distance++) {
+        entriesPerWord += choices;
+        choices = choices * (prefixLength - distance) / (distance + 1);
+    }
+    m_entries.reserve(m_words.size() * entriesPerWord);
+
+    for (qsizetype i = 0; i < m_words.size(); i++) {
+        forEachDelete(m_words.at(i).left(prefixLength), [this, i](QStringView variant) {
+            m_entries.append({hashOf(variant), quint32(i)});
+        });
+    }
+
+    std::sort(m_entries.begin(), m_entries.end());
+    m_entries.erase(std::unique(m_entries.begin(), m_entries.end()), m_entries.end());
+    m_entries.squeeze();
+}
+
+QStringList SpellingCorrector::suggestions(QStringView word, int maxCount) const
+{
+    if (word.isEmpty() || m_entries.isEmpty())
+        return {};
+
+    QVarLengthArray<quint32, 256> candidates;
+    auto collect = [this, &candidates](QStringView variant) {
+        auto range = std::equal_range(m_entries.cbegin(), m_entries.cend(), Entry{hashOf(variant), 0},
+                                      [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+        for (auto it = range.first; it != range.second; ++it)
+            candidates.append(it->word);
+    };
+
+    forEachDelete(word.left(prefixLength), collect);
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    struct Suggestion
+    {
+        int distance;
+        qsizetype lengthDifference;
+        quint32 word;
+    };
+    QVarLengthArray<Suggestion, 64> ranked;
+    for (auto candidate: candidates) {
+        auto candidateWord = m_words.at(candidate);
+        if (candidateWord == word)
+            continue;
+        auto distance = editDistance(word, candidateWord, maxDistance);
+        if (distance <= maxDistance)
+            ranked.append({distance, qAbs(candidateWord.size() - word.size()), candidate});
+    }
+
+    // Closest first, then the most similar length, then alphabetically
+    std::sort(ranked.begin(), ranked.end(), [](const Suggestion& a, const Suggestion& b) {
+        if (a.distance != b.distance)
+            return a.distance < b.distance;
+        if (a.lengthDifference != b.lengthDifference)
+            return a.lengthDifference < b.lengthDifference;
+        return a.word < b.word;
+    });
+
+    QStringList result;
+    for (int i = 0; i < ranked.size() && i < maxCount; i++)
+        result << m_words.at(ranked[i].word).toString();
+    return result;
+}
+
+int SpellingCorrector::editDistance(QStringView a, QStringView b, int limit)
+{
+    if (qAbs(a.size() - b.size()) > limit)
+        return limit + 1;
+
+    // Three rows of the optimal string alignment matrix
+    QVarLengthArray<int, 64> previousRow(b.size() + 1);
+    QVarLengthArray<int, 64> row(b.size() + 1);
+    QVarLengthArray<int, 64> nextRow(b.size() + 1);
+
+    for (qsizetype j = 0; j <= b.size(); j++)
+        row[j] = j;
+
+    for (qsizetype i = 1; i <= a.size(); i++) {
+        nextRow[0] = i;
+        int rowMinimum = nextRow[0];
+
+        for (qsizetype j = 1; j <= b.size(); j++) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            nextRow[j] = std::min({row[j] + 1, nextRow[j - 1] + 1, row[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                nextRow[j] = std::min(nextRow[j], previousRow[j - 2] + 1);
+            rowMinimum = std::min(rowMinimum, nextRow[j]);
+        }
+
+        if (rowMinimum > limit)
+            return limit + 1;
+
+        std::swap(previousRow, row);
+        std::swap(row, nextRow);
+    }
+
+    return std::min(row[b.size()], limit + 1);
+}
+
+quint32 SpellingCorrector::hashOf(QStringView text)
+{
+    return quint32(qHash(text, 0));
+}
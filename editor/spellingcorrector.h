@@ -0,0 +1,75 @@
+#pragma once
+
+#include "wordlist.h"
+
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class SpellingCorrector
+ * @brief Symmetric-delete index over a WordList that suggests corrections
+ *        for misspelled words.
+ *
+ * Every dictionary word is indexed under its first `prefixLength` characters
+ * and all the strings obtained by deleting up to `maxDistance` of them. A
+ * lookup generates the same deletes for the misspelled word, so candidates
+ * up to `maxDistance` edits (insertions, deletions, substitutions or
+ * transpositions) within the prefix are found with a few binary searches
+ * instead of a scan of the dictionary. Candidates are then ranked by their
+ * real edit distance over the whole word.
+ *
+ * Deletes are stored as 32-bit hashes next to the word index, which keeps the
+ * index at 8 bytes per entry, at most 29 entries per word; hash collisions
+ * are filtered out by the edit distance check.
+ */
+class SpellingCorrector
+{
+public:
+    static constexpr int prefixLength = 7; ///< Characters of each word that are indexed.
+    static constexpr int maxDistance = 2; ///< Largest edit distance of a suggestion.
+
+    /**
+     * @brief Builds the index, which takes a while for large dictionaries.
+     */
+    explicit SpellingCorrector(const WordList& words);
+
+    /**
+     * @brief Returns the closest dictionary words, nearest first.
+     *
+     * @param word A normalized word, see `WordTokenizer::normalize()`.
+     * @param maxCount Maximum number of suggestions.
+     */
+    QStringList suggestions(QStringView word, int maxCount = 5) const;
+
+    /**
+     * @brief Optimal string alignment distance between two words.
+     *
+     * @return The distance, or `limit + 1` as soon as it is known to exceed `limit`.
+     */
+    static int editDistance(QStringView a, QStringView b, int limit);
+
+private:
+    struct Entry
+    {
+        quint32 hash; ///< Hash of the prefix or of one of its deletes.
+        quint32 word; ///< Index of the word in `m_words`.
+
+        bool operator<(const Entry& other) const
+        {
+            return hash < other.hash || (hash == other.hash && word < other.word);
+        }
+        bool operator==(const Entry& other) const { return hash == other.hash && word == other.word; }
+    };
+
+    static quint32 hashOf(QStringView text);
+
+    /**
+     * @brief Calls `callback` with `prefix` and each distinct string obtained
+     *        by deleting up to `maxDistance` of its characters.
+     */
+    template<typename Callback>
+    static void forEachDelete(QStringView prefix, Callback callback);
+
+    WordList m_words;
+    QVector<Entry> m_entries; ///< Sorted by hash.
+};
@@ -0,0 +1,56 @@
+#include "taglist.h"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QVector>
+
+namespace {
+
+struct TagTable
+{
+    QReadWriteLock lock;
+    QVector<QStringList> lists{QStringList()};
+    QHash<QStringList, quint32> ids;
+};
+
+TagTable& tagTable()
+{
+    static TagTable table;
+    return table;
+}
+
+}
+
+QStringList TagList::toStringList() const
+{
+    if (!m_id)
+        return {};
+
+    auto& table = tagTable();
+    QReadLocker locker(&table.lock);
+    return table.lists[m_id];
+}
+
+quint32 TagList::intern(const QStringList& tags)
+{
+    if (tags.isEmpty())
+        return 0;
+
+    auto& table = tagTable();
+    {
+        QReadLocker locker(&table.lock);
+        auto found = table.ids.constFind(tags);
+        if (found != table.ids.cend())
+            return *found;
+    }
+
+    QWriteLocker locker(&table.lock);
+    auto found = table.ids.constFind(tags);
+    if (found != table.ids.cend())
+        return *found;
+
+    quint32 id = table.lists.size();
+    table.lists.append(tags);
+    table.ids.insert(tags, id);
+    return id;
+}
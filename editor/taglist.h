@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QStringList>
+
+/**
+ * @class TagList
+ * @brief Interned list of tags attached to a block or a word.
+ *
+ * Most words carry no tags, and the few tag combinations in use repeat all
+ * over a transcript, so each distinct list is stored once in a process wide
+ * table and words only keep its 32-bit id. Id 0 is the empty list, which
+ * needs no table lookup.
+ *
+ * Converts implicitly from and to QStringList, so code written against tag
+ * string lists keeps working.
+ */
+class TagList
+{
+public:
+    TagList() = default;
+    TagList(const QStringList& tags) : m_id(intern(tags)) {}
+
+    operator QStringList() const { return toStringList(); }
+
+    QStringList toStringList() const;
+
+    bool isEmpty() const { return !m_id; }
+    bool empty() const { return !m_id; }
+    qsizetype size() const { return toStringList().size(); }
+    bool contains(const QString& tag) const { return m_id && toStringList().contains(tag); }
+    QString join(const QString& separator) const { return toStringList().join(separator); }
+
+    bool operator==(const TagList& other) const { return m_id == other.m_id; }
+    bool operator!=(const TagList& other) const { return m_id != other.m_id; }
+
+private:
+    static quint32 intern(const QStringList& tags);
+
+    quint32 m_id{0}; ///< Index in the tag table, 0 for no tags.
+};
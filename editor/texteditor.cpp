@@ -1,6 +1,8 @@
 #include "texteditor.h"
 
+#include <QMouseEvent>
 #include <QPainter>
+#include <QScrollBar>
 #include <QTextBlock>
 #include <QtConcurrent/qtconcurrentrun.h>
 #include <qfuture.h>
@@ -9,6 +11,8 @@
 TextEditor::TextEditor(QWidget *parent) : QPlainTextEdit(parent)
 {
     lineNumberArea = new LineNumberArea(this);
+    timeStampArea = new TimeStampArea(this);
+    timeStampArea->hide();
     // m_debounceTimer = new QTimer(this);
     // m_debounceTimer->setSingleShot(true);
     // connect(m_debounceTimer, &QTimer::timeout, this, &TextEditor::processContentChanges);
@@ -26,7 +30,7 @@ TextEditor::TextEditor(QWidget *parent) : QPlainTextEdit(parent)
 int TextEditor::lineNumberAreaWidth()
 {
     int digits = 1;
-    int max = qMax(1, blockCount());
+    int max = qMax(1, totalBlockCount());
     while (max >= 10) {
         max /= 10;
         ++digits;
@@ -37,6 +41,111 @@ int TextEditor::lineNumberAreaWidth()
     return space;
 }
 
+int TextEditor::timeStampAreaWidth()
+{
+    if (!m_timeStampAreaVisible)
+        return 0;
+    return 12 + QFontMetrics(document()->defaultFont()).horizontalAdvance(QStringLiteral("00:00:00.000"));
+}
+
+void TextEditor::setTimeStampAreaVisible(bool visible)
+{
+    if (m_timeStampAreaVisible == visible)
+        return;
+
+    m_timeStampAreaVisible = visible;
+    timeStampArea->setVisible(visible);
+    updateLineNumberAreaWidth(0);
+    updateTimeStampAreaGeometry();
+}
+
+void TextEditor::setTimeStampAreaFont(const QFont& font)
+{
+    timeStampArea->setFont(font);
+    updateLineNumberAreaWidth(0);
+    updateTimeStampAreaGeometry();
+}
+
+void TextEditor::updateTimeStampAreaGeometry()
+{
+    QRect cr = contentsRect();
+    int right = cr.right() + 1 - blockScrollBarWidth();
+    timeStampArea->setGeometry(QRect(right - timeStampAreaWidth(), cr.top(), timeStampAreaWidth(), cr.height()));
+}
+
+void TextEditor::setBlockScrollBar(QScrollBar* scrollBar)
+{
+    m_blockScrollBar = scrollBar;
+    m_blockScrollBar->setParent(this);
+    m_blockScrollBar->show();
+
+    // Hidden, the viewport keeps scrolling through it
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    updateLineNumberAreaWidth(0);
+    updateTimeStampAreaGeometry();
+    updateBlockScrollBarGeometry();
+}
+
+void TextEditor::updateBlockScrollBarGeometry()
+{
+    if (!m_blockScrollBar)
+        return;
+
+    QRect cr = contentsRect();
+    m_blockScrollBar->setGeometry(QRect(cr.right() + 1 - blockScrollBarWidth(), cr.top(), blockScrollBarWidth(), cr.height()));
+}
+
+int TextEditor::blockScrollBarWidth() const
+{
+    return m_blockScrollBar ? m_blockScrollBar->sizeHint().width() : 0;
+}
+
+void TextEditor::updateLineNumbers()
+{
+    updateLineNumberAreaWidth(0);
+    lineNumberArea->update();
+}
+
+void TextEditor::setHighlightedTimeStamp(int blockNumber)
+{
+    if (m_highlightedTimeStamp == blockNumber)
+        return;
+
+    m_highlightedTimeStamp = blockNumber;
+    timeStampArea->update();
+}
+
+void TextEditor::updateTimeStampArea()
+{
+    timeStampArea->update();
+}
+
+QString TextEditor::blockTimeStamp(int /* blockNumber */) const
+{
+    return {};
+}
+
+int TextEditor::firstBlockNumber() const
+{
+    return 0;
+}
+
+int TextEditor::totalBlockCount() const
+{
+    return blockCount();
+}
+
+bool TextEditor::findMatch(const QRegularExpression& expression, QTextDocument::FindFlags options)
+{
+    if (!textCursor().hasSelection()) {
+        QTextCursor textCursor = this->textCursor();
+        textCursor.movePosition(options & QTextDocument::FindBackward ? QTextCursor::End : QTextCursor::Start);
+        setTextCursor(textCursor);
+    }
+
+    return find(expression, options);
+}
+
 
 void TextEditor::findReplace()
 {
@@ -52,17 +161,67 @@ void TextEditor::findReplace()
     m_findReplace->show();
 }
 
+int TextEditor::replaceAll(const QRegularExpression& expression, const QString& replacement, bool expandGroups)
+{
+    int replacementCount = 0;
+
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    for (auto block = document()->begin(); block.isValid(); block = block.next()) {
+        // Replaced from the end, so the earlier match offsets stay valid
+        QList<QRegularExpressionMatch> matches;
+        for (auto it = expression.globalMatch(block.text()); it.hasNext();)
+            matches.append(it.next());
+
+        for (auto match = matches.crbegin(); match != matches.crend(); ++match) {
+            cursor.setPosition(block.position() + match->capturedStart());
+            cursor.setPosition(block.position() + match->capturedEnd(), QTextCursor::KeepAnchor);
+            cursor.insertText(replacementText(replacement, *match, expandGroups));
+        }
+        replacementCount += matches.size();
+    }
+    cursor.endEditBlock();
+
+    return replacementCount;
+}
+
+QString TextEditor::expandReplacement(const QString& replacement, const QRegularExpressionMatch& match)
+{
+    if (!replacement.contains(u'\\'))
+        return replacement;
+
+    QString expanded;
+    expanded.reserve(replacement.size());
+    for (qsizetype i = 0; i < replacement.size(); i++) {
+        if (replacement[i] != u'\\' || i + 1 == replacement.size() || !replacement[i + 1].isDigit()) {
+            expanded.append(replacement[i]);
+            continue;
+        }
+
+        int group = replacement[++i].digitValue();
+        if (i + 1 < replacement.size() && replacement[i + 1].isDigit()
+            && group * 10 + replacement[i + 1].digitValue() <= match.lastCapturedIndex())
+            group = group * 10 + replacement[++i].digitValue();
+        expanded.append(match.captured(group));
+    }
+    return expanded;
+}
+
 void TextEditor::updateLineNumberAreaWidth(int /* newBlockCount */)
 {
-    setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+    setViewportMargins(lineNumberAreaWidth(), 0, timeStampAreaWidth() + blockScrollBarWidth(), 0);
 }
 
 void TextEditor::updateLineNumberArea(const QRect &rect, int dy)
 {
-    if (dy)
+    if (dy) {
         lineNumberArea->scroll(0, dy);
-    else
+        timeStampArea->scroll(0, dy);
+    }
+    else {
         lineNumberArea->update(0, rect.y(), lineNumberArea->width(), rect.height());
+        timeStampArea->update(0, rect.y(), timeStampArea->width(), rect.height());
+    }
 
     if (rect.contains(viewport()->rect()))
         updateLineNumberAreaWidth(0);
@@ -74,6 +233,8 @@ void TextEditor::resizeEvent(QResizeEvent *e)
 
     QRect cr = contentsRect();
     lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+    updateTimeStampAreaGeometry();
+    updateBlockScrollBarGeometry();
 }
 
 // Debounce text changes
@@ -109,8 +270,6 @@ void TextEditor::highlightCurrentLine()
         return; // No need to recalculate if the selection hasn't changed
     }
 
-    QList<QTextEdit::ExtraSelection> extraSelections;
-
     if (!isReadOnly()) {
         QTextEdit::ExtraSelection selection;
 
@@ -120,11 +279,34 @@ void TextEditor::highlightCurrentLine()
         selection.format.setProperty(QTextFormat::FullWidthSelection, true);
         selection.cursor = textCursor();
         selection.cursor.clearSelection();
-        extraSelections.append(selection);
 
         m_cachedSelection = selection;
     }
 
+    updateExtraSelections();
+}
+
+void TextEditor::setPlaybackSelections(const QList<QTextEdit::ExtraSelection>& selections)
+{
+    m_playbackSelections = selections;
+    updateExtraSelections();
+}
+
+void TextEditor::setOccurrenceSelections(const QList<QTextEdit::ExtraSelection>& selections)
+{
+    m_occurrenceSelections = selections;
+    updateExtraSelections();
+}
+
+void TextEditor::updateExtraSelections()
+{
+    QList<QTextEdit::ExtraSelection> extraSelections;
+
+    if (!isReadOnly() && !m_cachedSelection.cursor.isNull())
+        extraSelections.append(m_cachedSelection);
+    extraSelections.append(m_occurrenceSelections);
+    extraSelections.append(m_playbackSelections);
+
     setExtraSelections(extraSelections);
 }
 
@@ -135,7 +317,7 @@ void TextEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
 
 
     QTextBlock block = firstVisibleBlock();
-    int blockNumber = block.blockNumber();
+    int blockNumber = firstBlockNumber() + block.blockNumber();
     int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
     int bottom = top + qRound(blockBoundingRect(block).height());
 
@@ -155,6 +337,42 @@ void TextEditor::lineNumberAreaPaintEvent(QPaintEvent *event)
     }
 }
 
+void TextEditor::timeStampAreaPaintEvent(QPaintEvent *event)
+{
+    QPainter painter(timeStampArea);
+    painter.fillRect(event->rect(), Qt::lightGray);
+
+    QTextBlock block = firstVisibleBlock();
+    int blockNumber = firstBlockNumber() + block.blockNumber();
+    int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
+    int bottom = top + qRound(blockBoundingRect(block).height());
+
+    // Drawn at the last line of wrapped blocks, where the timestamp ended the text
+    int lineHeight = QFontMetrics(document()->defaultFont()).height();
+    while (block.isValid() && top <= event->rect().bottom()) {
+        if (block.isVisible() && bottom >= event->rect().top()) {
+            auto timeStamp = blockTimeStamp(blockNumber);
+            if (!timeStamp.isEmpty()) {
+                painter.setPen(blockNumber == m_highlightedTimeStamp ? Qt::red : Qt::black);
+                painter.drawText(0, bottom - lineHeight, timeStampArea->width() - 6, lineHeight,
+                                 Qt::AlignRight, timeStamp);
+            }
+        }
+
+        block = block.next();
+        top = bottom;
+        bottom = top + qRound(blockBoundingRect(block).height());
+        ++blockNumber;
+    }
+}
+
+void TextEditor::timeStampAreaDoubleClickEvent(QMouseEvent *event)
+{
+    auto block = cursorForPosition(QPoint(0, event->position().toPoint().y())).block();
+    if (block.isValid())
+        emit timeStampDoubleClicked(firstBlockNumber() + block.blockNumber());
+}
+
 void TextEditor::keyPressEvent(QKeyEvent *event)
 {
     if (event->key() == Qt::Key_F && event->modifiers() == Qt::ControlModifier)
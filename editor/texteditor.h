@@ -5,6 +5,8 @@
 #include <QPlainTextEdit>
 
 class LineNumberArea;
+class TimeStampArea;
+class QScrollBar;
 
 class TextEditor : public QPlainTextEdit
 {
@@ -15,6 +17,9 @@ public:
     void updateLineNumberArea(const QRect &rect, int dy);
     void lineNumberAreaPaintEvent(QPaintEvent *event);
     int lineNumberAreaWidth();
+    void timeStampAreaPaintEvent(QPaintEvent *event);
+    void timeStampAreaDoubleClickEvent(QMouseEvent *event);
+    int timeStampAreaWidth();
     void highlightCurrentLine();
     void contentChanged(int position, int charsRemoved, int charsAdded);
     QTextEdit::ExtraSelection m_cachedSelection;
@@ -24,6 +29,104 @@ public:
         lineNumberArea->setFont(font);
     }
 
+    void setTimeStampAreaFont(const QFont& font);
+
+    /**
+     * @brief Shows or hides the timestamp area on the right of the text.
+     *
+     * Timestamps aren't part of the text, so this only changes the viewport
+     * margin and repaints.
+     */
+    void setTimeStampAreaVisible(bool visible);
+
+    /**
+     * @brief Draws the timestamp of block `blockNumber` highlighted, -1 for none.
+     */
+    void setHighlightedTimeStamp(int blockNumber);
+
+    /**
+     * @brief Repaints the timestamp area, after timestamps changed.
+     */
+    void updateTimeStampArea();
+
+    /**
+     * @brief Resizes and repaints the line number area, after lines outside
+     *        the document were added or removed.
+     */
+    void updateLineNumbers();
+
+    /**
+     * @brief Replaces the vertical scroll bar with `scrollBar`, drawn right of
+     *        the timestamp area.
+     *
+     * Used by editors whose document only holds a window of their text, so
+     * the scroll bar can cover all of it. The viewport still scrolls with the
+     * wheel and the keyboard.
+     */
+    void setBlockScrollBar(QScrollBar* scrollBar);
+
+    /**
+     * @brief Returns the scroll bar set by `setBlockScrollBar()`, or nullptr.
+     */
+    QScrollBar* blockScrollBar() const { return m_blockScrollBar; }
+
+    /**
+     * @brief Selects the next match of `expression` after the cursor, or the
+     *        previous one with `QTextDocument::FindBackward`.
+     *
+     * Without a selection the search starts at the start of the text, or at
+     * its end going backward.
+     *
+     * @return Whether a match was found.
+     */
+    virtual bool findMatch(const QRegularExpression& expression, QTextDocument::FindFlags options = {});
+
+    /**
+     * @brief Sets the selections drawn on top of the text for the playback position.
+     *
+     * They are combined with the current line highlight. Qt only repaints the
+     * rectangles of the selections that changed.
+     *
+     * @param selections The playback selections, an empty list removes them.
+     */
+    void setPlaybackSelections(const QList<QTextEdit::ExtraSelection>& selections);
+
+    /**
+     * @brief Sets the selections marking the occurrences of the word under the cursor.
+     *
+     * They are drawn below the playback selections.
+     *
+     * @param selections The occurrence selections, an empty list removes them.
+     */
+    void setOccurrenceSelections(const QList<QTextEdit::ExtraSelection>& selections);
+
+    /**
+     * @brief Replaces every match of `expression` with `replacement`, as one
+     *        undoable edit.
+     *
+     * With `expandGroups`, `\\1` to `\\99` in `replacement` stand for the
+     * captured groups, like in `QString::replace()`. Otherwise `replacement`
+     * is inserted as is, for plain text searches.
+     *
+     * @return The number of replaced matches.
+     */
+    virtual int replaceAll(const QRegularExpression& expression, const QString& replacement, bool expandGroups);
+
+    /**
+     * @brief Returns `replacement` with the `\\N` references replaced by the
+     *        groups captured by `match`.
+     */
+    static QString expandReplacement(const QString& replacement, const QRegularExpressionMatch& match);
+
+    /**
+     * @brief Returns the text replacing `match`, `replacement` expanded only
+     *        when `expandGroups` is set.
+     */
+    static QString replacementText(const QString& replacement, const QRegularExpressionMatch& match, bool expandGroups)
+    {
+        return expandGroups ? expandReplacement(replacement, match) : replacement;
+    }
+
 public slots:
     void findReplace();
 
@@ -31,17 +134,49 @@ signals:
     void message(const QString& text, int timeout = 5000);
     void openMessage(const QString& text);
 
+    /**
+     * @brief Emitted when the timestamp of a block is double clicked.
+     */
+    void timeStampDoubleClicked(int blockNumber);
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
     void keyPressEvent(QKeyEvent *event) override;
 
+    /**
+     * @brief Returns the timestamp drawn next to block `blockNumber`, empty for none.
+     */
+    virtual QString blockTimeStamp(int blockNumber) const;
+
+    /**
+     * @brief Returns the number of the first block of the document in the
+     *        whole text, which the gutters number from.
+     */
+    virtual int firstBlockNumber() const;
+
+    /**
+     * @brief Returns the number of blocks of the whole text.
+     */
+    virtual int totalBlockCount() const;
+
 private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
     // void highlightCurrentLine();
     // void updateLineNumberArea(const QRect &rect, int dy);
 
 private:
+    void updateExtraSelections();
+    void updateTimeStampAreaGeometry();
+    void updateBlockScrollBarGeometry();
+    int blockScrollBarWidth() const;
+
     QWidget *lineNumberArea;
+    QWidget *timeStampArea;
+    QScrollBar *m_blockScrollBar = nullptr;
+    bool m_timeStampAreaVisible{false};
+    int m_highlightedTimeStamp{-1};
+    QList<QTextEdit::ExtraSelection> m_playbackSelections;
+    QList<QTextEdit::ExtraSelection> m_occurrenceSelections;
     FindReplaceDialog *m_findReplace = nullptr;
     // QTimer *m_debounceTimer = nullptr;
     // void processContentChanges();
@@ -69,3 +204,29 @@ protected:
 private:
     TextEditor *m_editor;
 };
+
+class TimeStampArea : public QWidget
+{
+public:
+    explicit TimeStampArea(TextEditor *parentEditor) : QWidget(parentEditor), m_editor(parentEditor)
+    {}
+
+    QSize sizeHint() const override
+    {
+        return QSize(m_editor->timeStampAreaWidth(), 0);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        m_editor->timeStampAreaPaintEvent(event);
+    }
+
+    void mouseDoubleClickEvent(QMouseEvent *event) override
+    {
+        m_editor->timeStampAreaDoubleClickEvent(event);
+    }
+
+private:
+    TextEditor *m_editor;
+};
@@ -0,0 +1,120 @@
+#include "timecodec.h"
+
+namespace {
+
+/**
+ * @brief Reads the digits at `position`, returns -1 if there are none.
+ */
+int readNumber(QStringView text, qsizetype& position, int maxDigits)
+{
+    int value = 0;
+    int digits = 0;
+    for (; position < text.size() && digits < maxDigits; position++, digits++) {
+        unsigned digit = text[position].unicode() - u'0';
+        if (digit > 9)
+            break;
+        value = value * 10 + digit;
+    }
+    return digits ? value : -1;
+}
+
+void writeDigits(char16_t* buffer, int value, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--) {
+        buffer[i] = char16_t(u'0' + value % 10);
+        value /= 10;
+    }
+}
+
+}
+
+qint64 TimeCodec::parseMilliseconds(QStringView text, bool carryMinutes)
+{
+    auto colons = text.count(u':');
+    if (colons < 1 || colons > 2)
+        return TranscriptTime::noTime;
+
+    int fields[3];
+    int fieldCount = colons + 1;
+    int minutesField = fieldCount - 2;
+    int milliseconds = 0;
+    qsizetype position = 0;
+    for (int i = 0; i < fieldCount; i++) {
+        if (i && text[position++] != u':')
+            return TranscriptTime::noTime;
+        // Hours past 99 are written with more digits
+        int maxDigits = 2;
+        if (fieldCount == 3 && i == 0)
+            maxDigits = 6;
+        else if (carryMinutes && i == minutesField)
+            maxDigits = 8;
+        fields[i] = readNumber(text, position, maxDigits);
+        if (fields[i] < 0 || (position == text.size() && i + 1 < fieldCount))
+            return TranscriptTime::noTime;
+    }
+
+    if (position < text.size() && text[position] == u'.') {
+        position++;
+        auto fractionStart = position;
+        milliseconds = readNumber(text, position, 3);
+        if (milliseconds < 0)
+            return TranscriptTime::noTime;
+        for (auto digits = position - fractionStart; digits < 3; digits++)
+            milliseconds *= 10;
+    }
+    if (position != text.size())
+        return TranscriptTime::noTime;
+
+    qint64 hours = fieldCount == 3 ? fields[0] : 0;
+    int minutes = fields[minutesField];
+    int seconds = fields[minutesField + 1];
+    if (carryMinutes) {
+        hours += minutes / 60;
+        minutes %= 60;
+    }
+    if (minutes > 59 || seconds > 59)
+        return TranscriptTime::noTime;
+    return ((hours * 60 + minutes) * 60 + seconds) * 1000 + milliseconds;
+}
+
+QTime TimeCodec::parse(QStringView text, bool carryMinutes)
+{
+    auto milliseconds = parseMilliseconds(text, carryMinutes);
+    if (milliseconds < 0 || milliseconds >= TranscriptTime::msecsPerDay)
+        return {};
+    return QTime::fromMSecsSinceStartOfDay(int(milliseconds));
+}
+
+void TimeCodec::append(QString& text, qint64 milliseconds)
+{
+    if (milliseconds < 0)
+        return;
+
+    auto hours = milliseconds / 3600000;
+    if (hours > 99)
+        text.append(QString::number(hours / 100));
+
+    char16_t buffer[formattedSize] = {0, 0, u':', 0, 0, u':', 0, 0, u'.'};
+    writeDigits(buffer, int(hours % 100), 2);
+    writeDigits(buffer + 3, int(milliseconds / 60000 % 60), 2);
+    writeDigits(buffer + 6, int(milliseconds / 1000 % 60), 2);
+    writeDigits(buffer + 9, int(milliseconds % 1000), 3);
+    text.append(QStringView(buffer, formattedSize));
+}
+
+void TimeCodec::format(QString& text, qint64 milliseconds)
+{
+    // resize() keeps the capacity, clear() would release it
+    text.resize(0);
+    append(text, milliseconds);
+}
+
+QString TimeCodec::toString(qint64 milliseconds)
+{
+    QString text;
+    if (milliseconds >= 0) {
+        text.reserve(formattedSize);
+        append(text, milliseconds);
+    }
+    return text;
+}
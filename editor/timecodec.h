@@ -0,0 +1,60 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QString>
+#include <QStringView>
+#include <QTime>
+
+/**
+ * @class TimeCodec
+ * @brief Parses and formats transcript timestamps without going through
+ *        `QTime::fromString()` and `QTime::toString()`.
+ *
+ * Timestamps are read as `[h:]m:s[.z]`, with fields of one or two digits and
+ * up to three fractional digits, and written as `hh:mm:ss.zzz`. Hours aren't
+ * limited to a day, longer timestamps just have more hour digits. Both work
+ * on integer milliseconds and a fixed-size buffer, so they don't allocate
+ * beyond the string they append to.
+ */
+class TimeCodec
+{
+public:
+    static constexpr qsizetype formattedSize = 12; ///< Characters of `hh:mm:ss.zzz`.
+
+    /**
+     * @brief Parses a timestamp into milliseconds.
+     *
+     * @param carryMinutes Also accept minutes past 59, carried into the hours,
+     *        as older versions wrote for line timestamps ("75:12.3" or
+     *        "0:75:12.3").
+     * @return The milliseconds, or `TranscriptTime::noTime` if `text` isn't a timestamp.
+     */
+    static qint64 parseMilliseconds(QStringView text, bool carryMinutes = false);
+
+    /**
+     * @brief Parses a timestamp, see `parseMilliseconds()`.
+     *
+     * @return The time, invalid if `text` isn't a timestamp within a day.
+     */
+    static QTime parse(QStringView text, bool carryMinutes = false);
+
+    /**
+     * @brief Appends `milliseconds` as `hh:mm:ss.zzz` to `text`, nothing if
+     *        it is `TranscriptTime::noTime`.
+     */
+    static void append(QString& text, qint64 milliseconds);
+    static void append(QString& text, QTime time) { append(text, TranscriptTime::fromTime(time)); }
+
+    /**
+     * @brief Replaces the contents of `text` with `milliseconds`, reusing its storage.
+     */
+    static void format(QString& text, qint64 milliseconds);
+    static void format(QString& text, QTime time) { format(text, TranscriptTime::fromTime(time)); }
+
+    /**
+     * @brief Returns `milliseconds` as `hh:mm:ss.zzz`, empty if it is `TranscriptTime::noTime`.
+     */
+    static QString toString(qint64 milliseconds);
+    static QString toString(QTime time) { return toString(TranscriptTime::fromTime(time)); }
+};
@@ -0,0 +1,143 @@
+#include "timeindex.h"
+
+#include <algorithm>
+
+void TimeIndex::update(const QVector<block>& blocks, int firstChanged)
+{
+    firstChanged = qBound(0, firstChanged, qMin(int(blocks.size()), blockCount()));
+    replace(blocks, firstChanged, blockCount() - firstChanged, blocks.size() - firstChanged);
+}
+
+void TimeIndex::replace(const QVector<block>& blocks, int first, int removed, int added)
+{
+    first = qBound(0, first, blockCount());
+    removed = qBound(0, removed, blockCount() - first);
+    added = qBound(0, added, int(blocks.size()) - first);
+
+    // Entries are inserted or removed in one go, the shared ones are overwritten
+    int blocksAdded = added - removed;
+    if (blocksAdded > 0) {
+        m_blockTimes.insert(first + removed, blocksAdded, noTime);
+        m_blockMaxTimes.insert(first + removed, blocksAdded, noTime);
+        m_previousBlockTimes.insert(first + removed, blocksAdded, noTime);
+        m_wordTimes.insert(first + removed, blocksAdded, QVector<WordTimes>());
+    }
+    else if (blocksAdded < 0) {
+        m_blockTimes.remove(first + added, -blocksAdded);
+        m_blockMaxTimes.remove(first + added, -blocksAdded);
+        m_previousBlockTimes.remove(first + added, -blocksAdded);
+        m_wordTimes.remove(first + added, -blocksAdded);
+    }
+
+    for (int i = first; i < first + added; i++) {
+        m_blockTimes[i] = blocks[i].time;
+        m_wordTimes[i] = indexWords(blocks[i]);
+    }
+    propagate(first, first + added);
+}
+
+void TimeIndex::update(const QVector<block>& blocks, const QVector<int>& changedBlocks)
+{
+    if (changedBlocks.isEmpty())
+        return;
+    if (blocks.size() != blockCount()) {
+        update(blocks, changedBlocks.first());
+        return;
+    }
+
+    for (auto i: changedBlocks) {
+        m_blockTimes[i] = blocks[i].time;
+        m_wordTimes[i] = indexWords(blocks[i]);
+    }
+    propagate(changedBlocks.first(), changedBlocks.last() + 1);
+}
+
+QVector<TimeIndex::WordTimes> TimeIndex::indexWords(const block& a_block)
+{
+    QVector<WordTimes> wordTimes;
+    wordTimes.reserve(a_block.wordCount());
+
+    qint64 maxTime = noTime;
+    qint64 previousTime = noTime;
+    for (qsizetype j = 0; j < a_block.wordCount(); j++) {
+        auto time = a_block.wordTime(j);
+        maxTime = qMax(maxTime, time);
+
+        wordTimes.append({maxTime, previousTime});
+        if (time != noTime)
+            previousTime = time;
+    }
+    return wordTimes;
+}
+
+void TimeIndex::propagate(int first, int end)
+{
+    qint64 maxTime = first ? m_blockMaxTimes[first - 1] : noTime;
+    qint64 previousTime = noTime;
+    if (first)
+        previousTime = m_blockTimes[first - 1] != noTime ? m_blockTimes[first - 1] : m_previousBlockTimes[first - 1];
+
+    for (int i = first; i < blockCount(); i++) {
+        maxTime = qMax(maxTime, m_blockTimes[i]);
+
+        // The blocks after an unchanged one keep their values
+        if (i >= end && m_blockMaxTimes[i] == maxTime && m_previousBlockTimes[i] == previousTime)
+            break;
+
+        m_blockMaxTimes[i] = maxTime;
+        m_previousBlockTimes[i] = previousTime;
+        if (m_blockTimes[i] != noTime)
+            previousTime = m_blockTimes[i];
+    }
+}
+
+int TimeIndex::blockAt(const QTime& time) const
+{
+    // The first block raising the running maximum above the time has a timestamp after it
+    auto found = std::upper_bound(m_blockMaxTimes.cbegin(), m_blockMaxTimes.cend(), toMsecs(time));
+    return found == m_blockMaxTimes.cend() ? -1 : int(found - m_blockMaxTimes.cbegin());
+}
+
+int TimeIndex::wordAt(int blockNumber, const QTime& time) const
+{
+    if (blockNumber < 0 || blockNumber >= blockCount())
+        return -1;
+
+    auto& wordTimes = m_wordTimes[blockNumber];
+    auto found = std::upper_bound(wordTimes.cbegin(), wordTimes.cend(), toMsecs(time),
+                                  [](qint64 msecs, const WordTimes& times) { return msecs < times.maxTime; });
+    return found == wordTimes.cend() ? -1 : int(found - wordTimes.cbegin());
+}
+
+QPair<int, int> TimeIndex::blocksOverlapping(const QTime& from, const QTime& to) const
+{
+    int first = blockAt(from);
+    if (first == -1)
+        return {-1, -1};
+
+    // Blocks after the last timestamp play until the end
+    int last = blockAt(to);
+    return {first, last == -1 ? blockCount() - 1 : last};
+}
+
+QTime TimeIndex::blockTime(int blockNumber) const
+{
+    if (blockNumber < 0 || blockNumber >= blockCount())
+        return QTime();
+    return fromMsecs(m_blockTimes[blockNumber]);
+}
+
+QTime TimeIndex::previousBlockTime(int blockNumber) const
+{
+    if (blockNumber < 0 || blockNumber >= blockCount())
+        return QTime();
+    return fromMsecs(m_previousBlockTimes[blockNumber]);
+}
+
+QTime TimeIndex::previousWordTime(int blockNumber, int wordNumber) const
+{
+    if (blockNumber < 0 || blockNumber >= blockCount()
+        || wordNumber < 0 || wordNumber >= m_wordTimes[blockNumber].size())
+        return QTime();
+    return fromMsecs(m_wordTimes[blockNumber][wordNumber].previousTime);
+}
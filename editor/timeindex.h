@@ -0,0 +1,118 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QPair>
+#include <QTime>
+#include <QVector>
+
+/**
+ * @class TimeIndex
+ * @brief Sorted index of the block and word timestamps of a transcript, for
+ *        playback highlighting, jumps and seeking.
+ *
+ * Block and word timestamps mark where they end. Timestamps may be missing
+ * or out of order after edits, so the index keeps the running maximum of the
+ * valid timestamps, which is non-decreasing and can be binary searched, along
+ * with the previous valid timestamp of every block and word. Position and
+ * range queries are O(log n), jumps are O(1).
+ *
+ * Word times are kept per block, so editing a line only re-indexes its own
+ * words. The running values of the blocks after it are patched until they
+ * stop changing, see `replace()`.
+ */
+class TimeIndex
+{
+public:
+    /**
+     * @brief Re-indexes `blocks` from block `firstChanged` on, the blocks
+     *        before it are assumed unchanged.
+     */
+    void update(const QVector<block>& blocks, int firstChanged = 0);
+
+    /**
+     * @brief Updates the index after `removed` blocks at `first` were
+     *        replaced with `added` ones.
+     *
+     * Only the replaced blocks are re-indexed. The running maximum and
+     * previous timestamp of the blocks after them are patched until they
+     * match the stored values again, usually at the next timed block.
+     *
+     * @param blocks All the blocks, after the replacement.
+     */
+    void replace(const QVector<block>& blocks, int first, int removed, int added);
+
+    /**
+     * @brief Re-indexes the blocks `changedBlocks`, in increasing order,
+     *        which were replaced one for one.
+     *
+     * The running values are propagated once, from the first of them.
+     */
+    void update(const QVector<block>& blocks, const QVector<int>& changedBlocks);
+
+    int blockCount() const { return m_blockTimes.size(); }
+
+    /**
+     * @brief Returns the block being played at `time`, the first block whose
+     *        timestamp is after it, or -1 past the last timestamp.
+     */
+    int blockAt(const QTime& time) const;
+
+    /**
+     * @brief Returns the word of a block being played at `time`, the first word
+     *        whose timestamp is after it, or -1 if there is none.
+     */
+    int wordAt(int blockNumber, const QTime& time) const;
+
+    /**
+     * @brief Returns the range of blocks played between `from` and `to`,
+     *        (-1, -1) if there is none.
+     */
+    QPair<int, int> blocksOverlapping(const QTime& from, const QTime& to) const;
+
+    /**
+     * @brief Returns the timestamp of a block, invalid if it has none.
+     */
+    QTime blockTime(int blockNumber) const;
+
+    /**
+     * @brief Returns the last valid timestamp before a block, where it starts
+     *        playing, invalid if there is none.
+     */
+    QTime previousBlockTime(int blockNumber) const;
+
+    /**
+     * @brief Returns the last valid timestamp of the words before `wordNumber`
+     *        in the same block, invalid if there is none.
+     */
+    QTime previousWordTime(int blockNumber, int wordNumber) const;
+
+private:
+    static constexpr qint64 noTime = TranscriptTime::noTime;
+
+    static qint64 toMsecs(const QTime& time) { return TranscriptTime::fromTime(time); }
+    static QTime fromMsecs(qint64 msecs) { return TranscriptTime::toTime(msecs); }
+
+    /**
+     * @struct WordTimes
+     * @brief Indexed timestamps of a word, within its block.
+     */
+    struct WordTimes
+    {
+        qint64 maxTime; ///< Running maximum of the word timestamps up to this one.
+        qint64 previousTime; ///< Last valid timestamp before this word.
+    };
+
+    static QVector<WordTimes> indexWords(const block& a_block);
+
+    /**
+     * @brief Recomputes the running values from block `first`, at least up to
+     *        `end` and then until they are unchanged.
+     */
+    void propagate(int first, int end);
+
+    QVector<qint64> m_blockTimes; ///< Block timestamps in milliseconds, `noTime` when invalid.
+    QVector<qint64> m_blockMaxTimes; ///< Running maximum of `m_blockTimes`.
+    QVector<qint64> m_previousBlockTimes; ///< Last valid timestamp before each block.
+    QVector<QVector<WordTimes>> m_wordTimes; ///< Word times of each block.
+};
@@ -0,0 +1,169 @@
+#include "transcriptreader.h"
+#include "timecodec.h"
+
+#include <QFile>
+#include <QObject>
+
+namespace {
+
+// Compared as views, so element names are never copied
+constexpr QLatin1String transcriptElement("transcript");
+constexpr QLatin1String lineElement("line");
+constexpr QLatin1String wordElement("word");
+constexpr QLatin1String langAttribute("lang");
+constexpr QLatin1String timestampAttribute("timestamp");
+constexpr QLatin1String speakerAttribute("speaker");
+constexpr QLatin1String tagsAttribute("tags");
+constexpr QLatin1String isEditedAttribute("isEdited");
+
+constexpr qint64 bytesPerLine = 1024; ///< Rough size of a `<line>`, to reserve blocks from the file size.
+
+}
+
+TranscriptReader::TranscriptReader(QIODevice* device)
+    : m_reader(device), m_device(device)
+{
+    if (!m_reader.readNextStartElement()) {
+        m_atEnd = true;
+        return;
+    }
+
+    if (m_reader.name() == transcriptElement) {
+        m_language = m_reader.attributes().value(langAttribute).toString();
+    }
+    else {
+        m_reader.raiseError(QObject::tr("Incorrect file"));
+        m_atEnd = true;
+    }
+}
+
+bool TranscriptReader::readBlocks(QVector<block>& blocks, int maxBlocks)
+{
+    blocks.reserve(blocks.size() + maxBlocks);
+    for (int read = 0; read < maxBlocks && !m_atEnd;) {
+        if (!m_reader.readNextStartElement()) {
+            m_atEnd = true;
+            break;
+        }
+        if (m_reader.name() == lineElement) {
+            blocks.append(readLine());
+            read++;
+        }
+        else
+            m_reader.skipCurrentElement();
+    }
+
+    if (m_reader.hasError())
+        m_atEnd = true;
+    return !m_atEnd;
+}
+
+QVector<block> TranscriptReader::readAll()
+{
+    QVector<block> blocks;
+    blocks.reserve(qMax<qint64>(0, m_device->size() - m_device->pos()) / bytesPerLine);
+    while (readBlocks(blocks, chunkSize)) {}
+    return blocks;
+}
+
+int TranscriptReader::progress() const
+{
+    if (m_atEnd)
+        return 100;
+
+    auto size = m_device->size();
+    if (size <= 0)
+        return 0;
+    return int(qBound<qint64>(0, m_device->pos() * 100 / size, 99));
+}
+
+block TranscriptReader::readLine()
+{
+    block line;
+    {
+        auto attributes = m_reader.attributes();
+        line.time = TimeCodec::parseMilliseconds(attributes.value(timestampAttribute), true);
+        line.speaker = readSpeaker(attributes.value(speakerAttribute));
+        line.tagList = readTags(attributes.value(tagsAttribute));
+    }
+
+    // Lines tend to be as long as the previous one. Every word is appended to
+    // the text of the line, empty ones included, so they keep their indices.
+    line.reserve(m_lastWordCount, m_lastTextSize);
+    while (m_reader.readNextStartElement()) {
+        if (m_reader.name() == wordElement) {
+            auto attributes = m_reader.attributes();
+            auto wordTime = TimeCodec::parseMilliseconds(attributes.value(timestampAttribute));
+            auto wordTags = readTags(attributes.value(tagsAttribute));
+            bool isEdited = attributes.value(isEditedAttribute).compare(u"true", Qt::CaseInsensitive) == 0;
+            line.appendWord(wordTime, m_reader.readElementText(), wordTags, isEdited);
+        }
+        else
+            m_reader.skipCurrentElement();
+    }
+    m_lastWordCount = line.wordCount();
+    m_lastTextSize = line.text().size();
+    return line;
+}
+
+QString TranscriptReader::readSpeaker(QStringView text)
+{
+    // A transcript has a handful of speakers, their names are shared
+    for (auto& speaker: std::as_const(m_speakers)) {
+        if (speaker == text)
+            return speaker;
+    }
+    if (m_speakers.size() >= maxSharedSpeakers)
+        return text.toString();
+
+    m_speakers.append(text.toString());
+    return m_speakers.constLast();
+}
+
+TagList TranscriptReader::readTags(QStringView text)
+{
+    if (text.isEmpty())
+        return {};
+
+    // Tag combinations repeat over a transcript
+    if (text != m_lastTagText) {
+        m_lastTagText = text.toString();
+        m_lastTagList = TagList(m_lastTagText.split(u','));
+    }
+    return m_lastTagList;
+}
+
+void TranscriptReader::loadTranscript(QPromise<TranscriptChunk>& promise, quint64 generation, QString fileName)
+{
+    TranscriptChunk chunk;
+    chunk.generation = generation;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        chunk.finished = true;
+        chunk.errorString = file.errorString();
+        promise.addResult(std::move(chunk));
+        return;
+    }
+
+    TranscriptReader reader(&file);
+    chunk.language = reader.language();
+
+    // A small first chunk fills the first screen, larger ones follow
+    int maxBlocks = firstChunkSize;
+    bool more = true;
+    while (more) {
+        if (promise.isCanceled())
+            return;
+
+        TranscriptChunk next = chunk;
+        more = reader.readBlocks(next.blocks, maxBlocks);
+        next.progress = reader.progress();
+        next.finished = !more;
+        if (reader.hasError())
+            next.errorString = reader.errorString();
+        promise.addResult(std::move(next));
+
+        maxBlocks = chunkSize;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QIODevice>
+#include <QPromise>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QXmlStreamReader>
+
+/**
+ * @struct TranscriptChunk
+ * @brief Run of consecutive blocks parsed by the worker, in file order.
+ */
+struct TranscriptChunk
+{
+    quint64 generation{0}; ///< Load the blocks belong to.
+    QString language; ///< Language of the transcript, set on every chunk.
+    QVector<block> blocks; ///< Parsed blocks, appended after the previous chunks.
+    int progress{0}; ///< Percentage of the file read so far.
+    bool finished{false}; ///< Last chunk of the load, `blocks` may be empty.
+    QString errorString; ///< Set on the last chunk if the file couldn't be read.
+};
+
+/**
+ * @class TranscriptReader
+ * @brief Reads the `<transcript>` XML format a few lines at a time.
+ *
+ * Only reads its device, so a reader can run on a worker thread while the
+ * editor shows the blocks parsed so far. Names and attributes are compared
+ * and parsed as views, and the words are appended to the text of their line,
+ * so the strings allocated per line are the line text and a temporary per word.
+ */
+class TranscriptReader
+{
+public:
+    static constexpr int firstChunkSize = 200; ///< Lines reported first, enough for the first screen.
+    static constexpr int chunkSize = 2000; ///< Lines reported per TranscriptChunk after the first.
+
+    /**
+     * @brief Starts reading `device`, which must be open, and reads the
+     *        `<transcript>` element with its language.
+     */
+    explicit TranscriptReader(QIODevice* device);
+
+    /**
+     * @brief Appends up to `maxBlocks` lines to `blocks`.
+     *
+     * @return False once the transcript is read to the end or on an error.
+     */
+    bool readBlocks(QVector<block>& blocks, int maxBlocks);
+
+    /**
+     * @brief Reads the remaining lines.
+     */
+    QVector<block> readAll();
+
+    QString language() const { return m_language; }
+    bool hasError() const { return m_reader.hasError(); }
+    QString errorString() const { return m_reader.errorString(); }
+
+    /**
+     * @brief Returns the percentage of the device read so far.
+     */
+    int progress() const;
+
+    /**
+     * @brief Parses the transcript `fileName` on a worker thread.
+     *
+     * Stops early when the promise is canceled.
+     *
+     * @param promise Receives one TranscriptChunk per run of lines, the last
+     *        one is marked `finished`.
+     * @param generation Tag copied into every chunk.
+     * @param fileName Transcript file to read.
+     */
+    static void loadTranscript(QPromise<TranscriptChunk>& promise, quint64 generation, QString fileName);
+
+private:
+    /**
+     * @brief Reads the `<line>` element the reader is on.
+     */
+    block readLine();
+
+    /**
+     * @brief Returns the speaker named `text`, sharing the name with the
+     *        previous lines of that speaker.
+     */
+    QString readSpeaker(QStringView text);
+
+    /**
+     * @brief Returns the tags of a comma separated list, reusing the previous
+     *        list when it repeats.
+     */
+    TagList readTags(QStringView text);
+
+    QXmlStreamReader m_reader;
+    QIODevice* m_device;
+    QString m_language;
+    bool m_atEnd{false};
+    qsizetype m_lastWordCount{0}; ///< Words of the previous line, reserved for the next one.
+    qsizetype m_lastTextSize{0}; ///< Text size of the previous line, reserved for the next one.
+    QString m_lastTagText; ///< Last tag list read.
+    TagList m_lastTagList; ///< Interned `m_lastTagText`.
+    QStringList m_speakers; ///< Speakers read so far, up to `maxSharedSpeakers`.
+
+    static constexpr int maxSharedSpeakers = 64;
+};
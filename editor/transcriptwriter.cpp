@@ -0,0 +1,62 @@
+#include "transcriptwriter.h"
+#include "timecodec.h"
+
+#include <QSaveFile>
+#include <QXmlStreamWriter>
+
+void TranscriptWriter::write(QIODevice* device, const QString& language, const QVector<block>& blocks)
+{
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement("transcript");
+
+    if (language != "")
+        writer.writeAttribute("lang", language);
+
+    // Formatted into one buffer, reused by every block and word
+    QString timeStampString;
+    timeStampString.reserve(TimeCodec::formattedSize);
+
+    for (auto& a_block: blocks) {
+        if (!a_block.text().isEmpty()) {
+            TimeCodec::format(timeStampString, a_block.time);
+
+            writer.writeStartElement("line");
+            writer.writeAttribute("timestamp", timeStampString);
+            writer.writeAttribute("speaker", a_block.speaker);
+
+            if (!a_block.tagList.isEmpty())
+                writer.writeAttribute("tags", a_block.tagList.join(","));
+
+            for (qsizetype j = 0; j < a_block.wordCount(); j++) {
+                writer.writeStartElement("word");
+                TimeCodec::format(timeStampString, a_block.wordTime(j));
+                writer.writeAttribute("timestamp", timeStampString);
+                writer.writeAttribute("isEdited", a_block.isWordEdited(j) ? "true": "false");
+
+                auto wordTags = a_block.wordTags(j);
+                if (!wordTags.isEmpty())
+                    writer.writeAttribute("tags", wordTags.join(","));
+
+                writer.writeCharacters(a_block.wordText(j).toString());
+                writer.writeEndElement();
+            }
+            writer.writeEndElement();
+        }
+    }
+    writer.writeEndElement();
+}
+
+QString TranscriptWriter::save(QString fileName, QString language, QVector<block> blocks)
+{
+    // QSaveFile writes next to the target, syncs and renames on commit()
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return file.errorString();
+
+    write(&file, language, blocks);
+    if (!file.commit())
+        return file.errorString();
+    return {};
+}
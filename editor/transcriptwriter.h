@@ -0,0 +1,42 @@
+#pragma once
+
+#include "blockandword.h"
+
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class TranscriptWriter
+ * @brief Writes transcripts in the `<transcript>` XML format read by
+ *        TranscriptReader.
+ *
+ * Only reads its arguments, so a save can run on a worker thread against a
+ * snapshot of the blocks while editing goes on.
+ */
+class TranscriptWriter
+{
+public:
+    /**
+     * @brief Writes `blocks` to `device`, which must be open.
+     *
+     * Each block is a "line" element with its timestamp, speaker and tags,
+     * holding its words as "word" elements. Blocks without text are skipped.
+     *
+     * @param device Device the XML is written to.
+     * @param language Language of the transcript, omitted if empty.
+     * @param blocks Blocks of the transcript.
+     */
+    static void write(QIODevice* device, const QString& language, const QVector<block>& blocks);
+
+    /**
+     * @brief Saves a transcript to `fileName`, replacing it atomically.
+     *
+     * The XML is written to a temporary file next to `fileName`, synced to
+     * disk and renamed over it, so a failed save leaves the previous file
+     * untouched.
+     *
+     * @return The error, empty if the transcript was saved.
+     */
+    static QString save(QString fileName, QString language, QVector<block> blocks);
+};
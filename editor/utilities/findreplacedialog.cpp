@@ -1,7 +1,10 @@
 #include "findreplacedialog.h"
 #include "ui_findreplacedialog.h"
+#include "editor/texteditor.h"
 
-FindReplaceDialog::FindReplaceDialog(QPlainTextEdit *parentEditor)
+#include <QElapsedTimer>
+
+FindReplaceDialog::FindReplaceDialog(TextEditor *parentEditor)
     : QDialog (parentEditor),
     m_Editor(parentEditor),
     ui (new Ui::FindReplaceDialog)
@@ -12,11 +15,6 @@ FindReplaceDialog::FindReplaceDialog(QPlainTextEdit *parentEditor)
     connect(ui->button_replace, &QPushButton::clicked, this, &FindReplaceDialog::replace);
     connect(ui->button_replace_all, &QPushButton::clicked, this, &FindReplaceDialog::replaceAll);
 
-    connect(ui->whole_words, &QCheckBox::toggled, this, &FindReplaceDialog::updateFlags);
-    connect(ui->case_sensitive, &QCheckBox::toggled, this, &FindReplaceDialog::updateFlags);
-
-    flags = flags | QTextDocument::FindCaseSensitively;
-
     QTextCursor textCursor = m_Editor->textCursor();
     if (textCursor.hasSelection())
         ui->text_find->setText(textCursor.selectedText());
@@ -29,44 +27,51 @@ FindReplaceDialog::~FindReplaceDialog()
     delete ui;
 }
 
-void FindReplaceDialog::updateFlags()
+QRegularExpression FindReplaceDialog::expression(bool anchored) const
 {
-    QTextDocument::FindFlags tmp;
-
+    auto pattern = ui->regular_expression->isChecked() ? ui->text_find->text()
+                                                       : QRegularExpression::escape(ui->text_find->text());
     if (ui->whole_words->isChecked())
-        tmp = tmp | QTextDocument::FindWholeWords;
-    if (ui->case_sensitive->isChecked())
-        tmp = tmp | QTextDocument::FindCaseSensitively;
+        pattern = "\\b(?:" + pattern + ")\\b";
+    if (anchored)
+        pattern = QRegularExpression::anchoredPattern(pattern);
+
+    QRegularExpression::PatternOptions options = QRegularExpression::UseUnicodePropertiesOption;
+    if (!ui->case_sensitive->isChecked())
+        options |= QRegularExpression::CaseInsensitiveOption;
 
-    flags = tmp;
+    return QRegularExpression(pattern, options);
 }
 
-void FindReplaceDialog::findNext()
+bool FindReplaceDialog::isExpressionValid(const QRegularExpression& expression)
 {
-    if (!m_Editor->textCursor().hasSelection()) {
-        QTextCursor textCursor = m_Editor->textCursor();
-        textCursor.movePosition(QTextCursor::Start, QTextCursor::MoveAnchor,1);
-        m_Editor->setTextCursor(textCursor);
+    if (ui->text_find->text().isEmpty())
+        return false;
+    if (!expression.isValid()) {
+        emit message("Invalid regular expression: " + expression.errorString() + ".");
+        return false;
     }
+    return true;
+}
+
+void FindReplaceDialog::findNext()
+{
+    auto query = expression();
+    if (!isExpressionValid(query))
+        return;
 
-    QString query = ui->text_find->text();
-    m_Editor->find(query, flags);
-    if (m_Editor->textCursor().hasSelection() && m_Editor->textCursor().selectedText() == query)
-        emit message("Found word " + query + ".");
+    if (m_Editor->findMatch(query))
+        emit message("Found word " + m_Editor->textCursor().selectedText() + ".");
 }
 
 void FindReplaceDialog::findPrevious()
 {
-    if (!m_Editor->textCursor().hasSelection()) {
-        QTextCursor textCursor = m_Editor->textCursor();
-        textCursor.movePosition(QTextCursor::End, QTextCursor::MoveAnchor,1);
-        m_Editor->setTextCursor(textCursor);
-    }
+    auto query = expression();
+    if (!isExpressionValid(query))
+        return;
 
-    QString query = ui->text_find->text();
-    m_Editor->find(query, QTextDocument::FindBackward | flags);
-    if (m_Editor->textCursor().hasSelection() && m_Editor->textCursor().selectedText() == query)
-        emit message("Found word " + query + ".");
+    if (m_Editor->findMatch(query, QTextDocument::FindBackward))
+        emit message("Found word " + m_Editor->textCursor().selectedText() + ".");
 }
 
 void FindReplaceDialog::replace()
@@ -76,33 +81,31 @@ void FindReplaceDialog::replace()
         emit message("No selected words");
     else if (replacementString != "")
     {
-        if (m_Editor->textCursor().selectedText() == ui->text_find->text())
-            m_Editor->textCursor().insertText(replacementString);
-        //if case sensitive is off
-        else if (!ui->case_sensitive->isChecked()
-                 && m_Editor->textCursor().selectedText().toLower() == ui->text_find->text().toLower())
-            m_Editor->textCursor().insertText(replacementString);
-        else
+        auto query = expression(true);
+        if (!isExpressionValid(query))
             return;
 
+        auto match = query.match(m_Editor->textCursor().selectedText());
+        if (!match.hasMatch())
+            return;
+        m_Editor->textCursor().insertText(TextEditor::replacementText(replacementString, match,
+                                                                      ui->regular_expression->isChecked()));
+
         emit message("Replced " + ui->text_find->text() + " with " + replacementString + ".");
     }
 }
 
 void FindReplaceDialog::replaceAll()
 {
-    QTextCursor textCursor = m_Editor->textCursor();
-    textCursor.movePosition(QTextCursor::Start, QTextCursor::MoveAnchor,1);
-    m_Editor->setTextCursor(textCursor);
-
-    QString query = ui->text_find->text();
-    QString replacementString = ui->text_replace->text();
-    short replacementCount{0};
+    auto query = expression();
+    if (!isExpressionValid(query))
+        return;
 
-    while (m_Editor->find(query, flags)) {
-        m_Editor->textCursor().insertText(replacementString);
-        ++replacementCount;
-    }
+    QElapsedTimer timer;
+    timer.start();
+    // Backslashes only refer to groups when searching for an expression
+    int replacementCount = m_Editor->replaceAll(query, ui->text_replace->text(), ui->regular_expression->isChecked());
 
-    emit message("Replaced " + QString::number(replacementCount) + " occurences.");
+    emit message("Replaced " + QString::number(replacementCount) + " occurences in "
+                 + QString::number(timer.elapsed()) + " ms.");
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <QDialog>
-#include <QPlainTextEdit>
+#include <QRegularExpression>
+
+class TextEditor;
 
 namespace Ui {
 class FindReplaceDialog;
@@ -11,11 +13,10 @@ class FindReplaceDialog : public QDialog
 {
     Q_OBJECT
 public:
-    explicit FindReplaceDialog(QPlainTextEdit *parentEditor);
+    explicit FindReplaceDialog(TextEditor *parentEditor);
     ~FindReplaceDialog();
 
 private slots:
-    void updateFlags();
     void findPrevious();
     void findNext();
     void replace();
@@ -24,7 +25,19 @@ signals:
     void message(const QString& text, int timeout = 2000);
 
 private:
-    QPlainTextEdit *m_Editor = nullptr;
+    /**
+     * @brief Builds the expression searched for from the find text and the
+     *        whole word, case and regular expression options.
+     *
+     * @param anchored Whether the expression must match the whole subject.
+     */
+    QRegularExpression expression(bool anchored = false) const;
+
+    /**
+     * @brief Checks the find expression, reporting it when it is invalid.
+     */
+    bool isExpressionValid(const QRegularExpression& expression);
+
+    TextEditor *m_Editor = nullptr;
     Ui::FindReplaceDialog *ui;
-    QTextDocument::FindFlags flags;
 };
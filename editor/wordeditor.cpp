@@ -1,4 +1,5 @@
 #include "wordeditor.h"
+#include "timecodec.h"
 
 #include <QHeaderView>
 
@@ -21,7 +22,7 @@ QVector<word> WordEditor::currentWords() const
 
     for (int i = 0; i < rowCount(); i++) {
         auto text = item(i, 0)->text();
-        auto timeStamp = getTime(item(i, 1)->text());
+        auto time = TimeCodec::parseMilliseconds(item(i, 1)->text());
         QStringList tagList;
 
         if (item(i, 2)->checkState() == Qt::Checked)
@@ -29,7 +30,7 @@ QVector<word> WordEditor::currentWords() const
         if (item(i, 3)->checkState() == Qt::Checked)
             tagList << "Slacked";
 
-        wordsToReturn.append(word {timeStamp, text, tagList});
+        wordsToReturn.append(word {time, text, tagList});
     }
 
     return wordsToReturn;
@@ -52,11 +53,11 @@ void WordEditor::refreshWords(const QVector<word>& words)
     int counter = 0;
     for (auto& a_word: words) {
         auto text = a_word.text;
-        auto timeStamp = a_word.timeStamp;
+        auto time = a_word.time;
         auto tagList = a_word.tagList;
 
         setItem(counter, 0, new QTableWidgetItem(text));
-        setItem(counter, 1, new QTableWidgetItem(timeStamp.toString("hh:mm:ss.zzz")));
+        setItem(counter, 1, new QTableWidgetItem(TimeCodec::toString(time)));
         setItem(counter, 2, new QTableWidgetItem);
         setItem(counter, 3, new QTableWidgetItem);
 
@@ -78,7 +79,7 @@ void WordEditor::refreshWords(const QVector<word>& words)
 
 void WordEditor::insertTimeStamp(const QTime& timeToInsert)
 {
-    item(currentRow(), 1)->setText(timeToInsert.toString("hh:mm:ss.zzz"));
+    item(currentRow(), 1)->setText(TimeCodec::toString(timeToInsert));
 }
 
 void WordEditor::fitTableContents()
@@ -88,17 +89,3 @@ void WordEditor::fitTableContents()
     horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
     horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
 }
-
-QTime WordEditor::getTime(const QString& text)
-{
-    if (text.contains(".")) {
-        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s.z");
-        return QTime::fromString(text, "m:s.z");
-    }
-    else {
-        if (text.count(":") == 2) return QTime::fromString(text, "h:m:s");
-        return QTime::fromString(text, "m:s");
-    }
-}
-
-
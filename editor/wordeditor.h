@@ -15,7 +15,4 @@ public:
 public slots:
     void refreshWords(const QVector<word>& words);
     void insertTimeStamp(const QTime& timeToInsert);
-
-private:
-    static QTime getTime(const QString& text);
 };
@@ -0,0 +1,63 @@
+#include "wordindex.h"
+
+#include <algorithm>
+
+void WordIndex::add(QStringView key, WordPosition position)
+{
+    if (key.isEmpty())
+        return;
+
+    auto& positions = m_positions[key.toString()];
+    auto it = std::lower_bound(positions.begin(), positions.end(), position);
+    if (it == positions.end() || !(*it == position))
+        positions.insert(it, position);
+}
+
+void WordIndex::remove(QStringView key, WordPosition position)
+{
+    auto found = m_positions.find(key.toString());
+    if (found == m_positions.end())
+        return;
+
+    auto& positions = *found;
+    auto it = std::lower_bound(positions.begin(), positions.end(), position);
+    if (it != positions.end() && *it == position)
+        positions.erase(it);
+    if (positions.isEmpty())
+        m_positions.erase(found);
+}
+
+void WordIndex::insertBlocks(int blockNumber, int count)
+{
+    for (auto& positions: m_positions) {
+        auto it = std::lower_bound(positions.begin(), positions.end(), WordPosition{blockNumber, 0});
+        for (; it != positions.end(); ++it)
+            it->block += count;
+    }
+}
+
+void WordIndex::removeBlocks(int blockNumber, int count)
+{
+    for (auto& positions: m_positions) {
+        auto it = std::lower_bound(positions.begin(), positions.end(), WordPosition{blockNumber + count, 0});
+        for (; it != positions.end(); ++it)
+            it->block -= count;
+    }
+}
+
+QVector<WordPosition> WordIndex::occurrences(QStringView key, int first, int last) const
+{
+    auto found = m_positions.constFind(key.toString());
+    if (found == m_positions.cend())
+        return {};
+
+    auto begin = std::lower_bound(found->cbegin(), found->cend(), WordPosition{first, 0});
+    auto end = std::lower_bound(begin, found->cend(), WordPosition{last + 1, 0});
+    return QVector<WordPosition>(begin, end);
+}
+
+int WordIndex::count(QStringView key) const
+{
+    auto found = m_positions.constFind(key.toString());
+    return found == m_positions.cend() ? 0 : found->size();
+}
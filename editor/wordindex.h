@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct WordPosition
+ * @brief Position of a word in the transcript.
+ */
+struct WordPosition
+{
+    int block; ///< Block number.
+    int word; ///< Word number in the block.
+
+    bool operator<(const WordPosition& other) const
+    {
+        return block < other.block || (block == other.block && word < other.word);
+    }
+    bool operator==(const WordPosition& other) const { return block == other.block && word == other.word; }
+};
+
+/**
+ * @class WordIndex
+ * @brief Inverted index from normalized words to their positions in the transcript.
+ *
+ * Positions of a word are kept sorted, so the occurrences in a range of blocks
+ * are found with a binary search. The index is updated block by block as the
+ * transcript is edited: the words of an edited block are removed and added
+ * again, and inserting or removing blocks shifts the positions after them.
+ */
+class WordIndex
+{
+public:
+    void clear() { m_positions.clear(); }
+
+    /**
+     * @brief Adds an occurrence of a word.
+     *
+     * @param key The normalized word, see `WordTokenizer::normalize()`.
+     */
+    void add(QStringView key, WordPosition position);
+
+    /**
+     * @brief Removes an occurrence of a word.
+     */
+    void remove(QStringView key, WordPosition position);
+
+    /**
+     * @brief Shifts the positions of blocks `blockNumber` and after by `count`,
+     *        to make room for inserted blocks.
+     */
+    void insertBlocks(int blockNumber, int count);
+
+    /**
+     * @brief Shifts the positions after the removed blocks [blockNumber,
+     *        blockNumber + count) back. Their words must be removed first.
+     */
+    void removeBlocks(int blockNumber, int count);
+
+    /**
+     * @brief Returns the positions of a word, in transcript order.
+     */
+    QVector<WordPosition> occurrences(QStringView key) const { return m_positions.value(key.toString()); }
+
+    /**
+     * @brief Returns the positions of a word in the blocks [first, last].
+     */
+    QVector<WordPosition> occurrences(QStringView key, int first, int last) const;
+
+    /**
+     * @brief Returns the number of occurrences of a word.
+     */
+    int count(QStringView key) const;
+
+private:
+    QHash<QString, QVector<WordPosition>> m_positions;
+};
@@ -0,0 +1,179 @@
+#include "wordlist.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr char magic[4] = {'V', 'W', 'L', '1'};
+constexpr qint64 headerSize = 8;
+
+QByteArray compileWords(QStringList words)
+{
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    words.removeAll(QString());
+
+    quint32 count = words.size();
+    qint64 chars = 0;
+    for (auto& a_word: std::as_const(words))
+        chars += a_word.size();
+
+    QByteArray data;
+    data.reserve(headerSize + sizeof(quint32) * (count + 1) + sizeof(char16_t) * chars);
+    data.append(magic, sizeof(magic));
+
+    auto appendNumber = [&data](quint32 number) {
+        number = qToLittleEndian(number);
+        data.append(reinterpret_cast<const char*>(&number), sizeof(number));
+    };
+
+    appendNumber(count);
+    quint32 offset = 0;
+    appendNumber(offset);
+    for (auto& a_word: std::as_const(words)) {
+        offset += a_word.size();
+        appendNumber(offset);
+    }
+    for (auto& a_word: std::as_const(words)) {
+        for (auto ch: a_word) {
+            auto unit = qToLittleEndian(ch.unicode());
+            data.append(reinterpret_cast<const char*>(&unit), sizeof(unit));
+        }
+    }
+
+    // Tables bundled after this one start at the same alignment
+    while (data.size() % sizeof(quint32))
+        data.append('\0');
+
+    return data;
+}
+
+}
+
+WordList WordList::fromFile(const QString& fileName)
+{
+    WordList list;
+
+    auto file = QSharedPointer<QFile>::create(fileName);
+    if (!file->open(QFile::ReadOnly))
+        return list;
+
+    if (file->peek(sizeof(magic)) != QByteArray(magic, sizeof(magic))) {
+        QStringList words;
+        while (!file->atEnd()) {
+            auto line = file->readLine().trimmed();
+            if (!line.isEmpty())
+                words << QString::fromUtf8(line);
+        }
+        return fromWords(words);
+    }
+
+    // Uncompressed resources and files on disk are mapped, anything else is read
+    if (auto data = file->map(0, file->size())) {
+        if (list.attach(data, file->size())) {
+            list.m_file = file;
+            return list;
+        }
+    }
+
+    qWarning() << "WordList: couldn't map" << fileName << "in place, reading a copy";
+    file->seek(0);
+    list.m_storage = file->readAll();
+    if (!list.attach(reinterpret_cast<const uchar*>(list.m_storage.constData()), list.m_storage.size()))
+        return WordList();
+    return list;
+}
+
+WordList WordList::fromResource(const QString& language)
+{
+    auto list = fromFile(QString(":/wordlists/%1.vwl").arg(language));
+    if (list.isEmpty())
+        list = fromFile(QString(":/wordlists/%1.txt").arg(language));
+    return list;
+}
+
+WordList WordList::fromWords(QStringList words)
+{
+    WordList list;
+    list.m_storage = compileWords(std::move(words));
+    list.attach(reinterpret_cast<const uchar*>(list.m_storage.constData()), list.m_storage.size());
+    return list;
+}
+
+WordList WordList::merged(const QStringList& words) const
+{
+    auto allWords = toStringList();
+    allWords.append(words);
+    return fromWords(allWords);
+}
+
+bool WordList::save(const QString& fileName) const
+{
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly))
+        return false;
+
+    if (!m_storage.isEmpty())
+        file.write(m_storage);
+    else
+        file.write(compileWords(toStringList()));
+
+    return file.commit();
+}
+
+qsizetype WordList::lowerBound(QStringView word) const
+{
+    qsizetype first = 0;
+    qsizetype count = m_count;
+
+    while (count > 0) {
+        auto step = count / 2;
+        auto middle = first + step;
+        if (at(middle) < word) {
+            first = middle + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+    return first;
+}
+
+QStringList WordList::toStringList() const
+{
+    QStringList words;
+    words.reserve(m_count);
+    for (quint32 i = 0; i < m_count; i++)
+        words << at(i).toString();
+    return words;
+}
+
+bool WordList::attach(const uchar* data, qint64 size)
+{
+    // The words are read in place, so they have to be little-endian and aligned
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian
+        || reinterpret_cast<quintptr>(data) % alignof(char16_t)
+        || size < headerSize
+        || memcmp(data, magic, sizeof(magic)))
+        return false;
+
+    quint32 count = qFromLittleEndian<quint32>(data + sizeof(magic));
+    qint64 offsetsEnd = headerSize + qint64(sizeof(quint32)) * (count + 1);
+    if (size < offsetsEnd)
+        return false;
+
+    auto offsets = data + headerSize;
+    if (size < offsetsEnd + qint64(sizeof(char16_t)) * qFromLittleEndian<quint32>(offsets + count * sizeof(quint32)))
+        return false;
+
+    m_offsets = offsets;
+    m_chars = reinterpret_cast<const char16_t*>(data + offsetsEnd);
+    m_count = count;
+    return true;
+}
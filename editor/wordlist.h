@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QStringView>
+#include <QtEndian>
+
+class QFile;
+
+/**
+ * @class WordList
+ * @brief Immutable sorted table of dictionary words, queried without allocation.
+ *
+ * Wordlists are compiled at build time (see `tools/wordlistcompiler.cpp`) into
+ * the following little-endian layout, which is memory-mapped straight from the
+ * resources or from disk:
+ *
+ * | Field              | Type                  |
+ * |--------------------|-----------------------|
+ * | magic `VWL1`       | 4 bytes               |
+ * | word count `n`     | quint32               |
+ * | word offsets       | quint32[n + 1]        |
+ * | words              | UTF-16 code units     |
+ * | padding            | zero bytes up to a multiple of 4 |
+ *
+ * Word `i` spans the code units [offsets[i], offsets[i + 1]). Words are unique
+ * and sorted by UTF-16 code units, the same order as `QString::operator<`.
+ *
+ * The padding keeps the tables bundled one after another in the resources at
+ * the alignment of the first. Only the words have to be 2-byte aligned to be
+ * read in place, the offsets are read unaligned. A table that can't be mapped
+ * or isn't aligned is copied, with a warning.
+ *
+ * Copies share the same mapping or buffer.
+ */
+class WordList
+{
+public:
+    WordList() = default;
+
+    /**
+     * @brief Loads a compiled wordlist, or compiles a plain text one (one word
+     *        per line, UTF-8) in memory.
+     *
+     * @param fileName Path of the file, resource paths included.
+     * @return The wordlist, empty if the file couldn't be read.
+     */
+    static WordList fromFile(const QString& fileName);
+
+    /**
+     * @brief Loads the bundled wordlist of a language, `:/wordlists/<language>.vwl`.
+     */
+    static WordList fromResource(const QString& language);
+
+    /**
+     * @brief Compiles a wordlist in memory from unsorted words.
+     */
+    static WordList fromWords(QStringList words);
+
+    /**
+     * @brief Returns a new wordlist holding these words and `words`.
+     */
+    WordList merged(const QStringList& words) const;
+
+    /**
+     * @brief Writes the wordlist in the compiled format.
+     *
+     * @return False if the file couldn't be written.
+     */
+    bool save(const QString& fileName) const;
+
+    bool isEmpty() const { return !m_count; }
+    qsizetype size() const { return m_count; }
+
+    /**
+     * @brief Returns word `i`, a view into the mapped table.
+     */
+    QStringView at(qsizetype i) const
+    {
+        auto start = offset(i);
+        return QStringView(m_chars + start, offset(i + 1) - start);
+    }
+
+    /**
+     * @brief Returns the index of the first word not less than `word`.
+     */
+    qsizetype lowerBound(QStringView word) const;
+
+    bool contains(QStringView word) const
+    {
+        auto i = lowerBound(word);
+        return i < m_count && at(i) == word;
+    }
+
+    /**
+     * @brief Checks whether both wordlists share the same table.
+     */
+    bool isSharedWith(const WordList& other) const { return m_offsets == other.m_offsets; }
+
+    QStringList toStringList() const;
+
+private:
+    bool attach(const uchar* data, qint64 size);
+
+    quint32 offset(qsizetype i) const { return qFromLittleEndian<quint32>(m_offsets + i * sizeof(quint32)); }
+
+    QByteArray m_storage; ///< Owned table when it wasn't mapped.
+    QSharedPointer<QFile> m_file; ///< Keeps the mapping alive.
+    const uchar* m_offsets{nullptr}; ///< Little-endian quint32 offsets, not necessarily aligned.
+    const char16_t* m_chars{nullptr};
+    quint32 m_count{0};
+};
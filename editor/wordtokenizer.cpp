@@ -0,0 +1,95 @@
+#include "wordtokenizer.h"
+
+bool WordTokenizer::next(WordSpan& span)
+{
+    if (m_position > m_text.size())
+        return false;
+
+    auto end = m_text.indexOf(u' ', m_position);
+    if (end == -1)
+        end = m_text.size();
+
+    span.start = m_position;
+    span.text = m_text.sliced(m_position, end - m_position);
+    span.key = strip(span.text);
+
+    m_position = end + 1;
+    return true;
+}
+
+qsizetype WordTokenizer::speakerEnd(QStringView text)
+{
+    // From the first '{' to the last "}:", as the greedy expression matches
+    auto end = text.lastIndexOf(u"}:");
+    if (end == -1)
+        return 0;
+    auto start = text.indexOf(u'{');
+    if (start == -1 || start > end)
+        return 0;
+    return end + 2;
+}
+
+qsizetype WordTokenizer::wordsStart(QStringView text)
+{
+    auto start = speakerEnd(text);
+    return start ? start + 1 : 0;
+}
+
+QStringView WordTokenizer::strip(QStringView word, QStringView punctuation)
+{
+    static constexpr char16_t openingMarks[] = u"\"([{'<";
+    static constexpr char16_t closingMarks[] = u"\")]}'>";
+    static constexpr char16_t trailingMarks[] = u"?!,";
+
+    if (!word.isEmpty() && punctuation.contains(word.back()))
+        word.chop(1);
+
+    for (int k = 0; k < 6; k++) {
+        if (!word.isEmpty() && word.front() == openingMarks[k])
+            word = word.sliced(1);
+        if (!word.isEmpty() && word.back() == closingMarks[k])
+            word.chop(1);
+    }
+    for (int k = 0; k < 3; k++) {
+        if (!word.isEmpty() && word.back() == trailingMarks[k])
+            word.chop(1);
+    }
+
+    return word;
+}
+
+QStringView WordTokenizer::lowercase(QStringView key, QString& buffer)
+{
+    bool hasUpper = false;
+    for (auto ch: key) {
+        if (ch.isSurrogate() || ch.toLower() != ch) {
+            hasUpper = true;
+            break;
+        }
+    }
+    if (!hasUpper)
+        return key;
+
+    buffer.resize(0);
+    buffer.append(key);
+    buffer = std::move(buffer).toLower();
+    return buffer;
+}
+
+bool WordTokenizer::containsTime(QStringView word)
+{
+    auto isDigit = [](QChar ch, char16_t max) {
+        return ch >= u'0' && ch <= max;
+    };
+
+    // ([0-1][0-9]|2[0-3]):([0-5][0-9]):([0-5][0-9]) anywhere in the word
+    for (qsizetype i = 0; i + 8 <= word.size(); i++) {
+        auto hours = word[i] == u'2' ? isDigit(word[i + 1], u'3')
+                                     : isDigit(word[i], u'1') && isDigit(word[i + 1], u'9');
+        if (hours
+            && word[i + 2] == u':' && isDigit(word[i + 3], u'5') && isDigit(word[i + 4], u'9')
+            && word[i + 5] == u':' && isDigit(word[i + 6], u'5') && isDigit(word[i + 7], u'9'))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * @struct WordSpan
+ * @brief A single word of a block as a view into the tokenized text.
+ */
+struct WordSpan
+{
+    qsizetype start{0}; ///< Offset of the word in the tokenized text.
+    QStringView text; ///< The word as written.
+    QStringView key; ///< The word without punctuation and enclosing marks, not yet lowercased.
+};
+
+/**
+ * @class WordTokenizer
+ * @brief Splits block text into space separated words and normalizes them
+ *        into dictionary keys without copying the text.
+ *
+ * Words are split on single spaces like `QString::split(" ")`, so empty words
+ * are kept and word numbers match the words stored in `block::words`.
+ */
+class WordTokenizer
+{
+public:
+    /**
+     * @brief Constructs a tokenizer over `text`, starting at offset `from`.
+     *
+     * @param text Text to split. It must outlive the tokenizer and the spans.
+     * @param from Offset of the first word, see `wordsStart()`.
+     */
+    explicit WordTokenizer(QStringView text, qsizetype from = 0)
+        : m_text(text), m_position(from) {}
+
+    /**
+     * @brief Reads the next word.
+     *
+     * @param span Receives the word.
+     * @return False once all the words were read.
+     */
+    bool next(WordSpan& span);
+
+    /**
+     * @brief Returns the end of the `{speaker}:` prefix, or 0 if there is none.
+     *
+     * Covers the same span as the `\{.*\}:` speaker expression.
+     */
+    static qsizetype speakerEnd(QStringView text);
+
+    /**
+     * @brief Returns the offset of the first word of a block text, after the
+     *        speaker prefix and the space following it.
+     */
+    static qsizetype wordsStart(QStringView text);
+
+    /**
+     * @brief Strips one trailing punctuation mark, the enclosing quotes and
+     *        brackets, and trailing `?`, `!` and `,` from a word.
+     *
+     * @param word The word as written.
+     * @param punctuation Marks of which one is stripped from the end first.
+     * @return The stripped word as a view into `word`.
+     */
+    static QStringView strip(QStringView word, QStringView punctuation = u",.!;:?");
+
+    /**
+     * @brief Returns the lowercase dictionary key of a stripped word.
+     *
+     * The key is returned as is when it has no uppercase letters, otherwise it
+     * is lowercased into `buffer`, whose storage is reused between calls.
+     *
+     * @param key A word returned by `strip()`.
+     * @param buffer Scratch string owned by the caller.
+     * @return The lowercase key, valid until `buffer` is modified.
+     */
+    static QStringView lowercase(QStringView key, QString& buffer);
+
+    /**
+     * @brief Shortcut for `lowercase(strip(word), buffer)`.
+     */
+    static QStringView normalize(QStringView word, QString& buffer)
+    {
+        return lowercase(strip(word), buffer);
+    }
+
+    /**
+     * @brief Checks whether the word contains a `hh:mm:ss` time, such words
+     *        are not spell-checked.
+     */
+    static bool containsTime(QStringView word);
+
+private:
+    QStringView m_text;
+    qsizetype m_position;
+};
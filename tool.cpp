@@ -193,6 +193,15 @@ Tool::Tool(QWidget *parent)
     connect(ui->editor_editTags, &QAction::triggered, ui->m_editor, &Editor::createTagSelectionDialog);
     connect(ui->editor_autoSave, &QAction::triggered, ui->m_editor, [this](){ui->m_editor->useAutoSave(ui->editor_autoSave->isChecked());});
     connect(ui->m_editor, &Editor::message, this->statusBar(), &QStatusBar::showMessage);
+    auto loadProgressBar = new QProgressBar(this->statusBar());
+    loadProgressBar->setRange(0, 100);
+    loadProgressBar->setMaximumWidth(150);
+    loadProgressBar->hide();
+    this->statusBar()->addPermanentWidget(loadProgressBar);
+    connect(ui->m_editor, &Editor::loadProgress, loadProgressBar, [loadProgressBar](int percent) {
+        loadProgressBar->setValue(percent);
+        loadProgressBar->setVisible(percent < 100);
+    });
     connect(ui->m_editor, &Editor::jumpToPlayer, player, &MediaPlayer::setPositionToTime);
     connect(ui->m_editor, &Editor::refreshTagList, ui->m_tagListDisplay, &TagListDisplayWidget::refreshTags);
     connect(ui->Show_Time_Stamps, &QAction::triggered, ui->m_editor,&Editor::setShowTimeStamp );
@@ -542,7 +551,7 @@ void Tool::on_btn_translate_clicked()
     }
     QString x("");
     for (auto& a_block : std::as_const(ui->m_editor_2->m_blocks)) {
-        auto blockText = a_block.text + " " ;
+        auto blockText = a_block.text() + " " ;
         //            qInfo()<<a_block.text;
         x.append(blockText + "\n");
     }
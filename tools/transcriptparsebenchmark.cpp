@@ -0,0 +1,102 @@
+// Measures the throughput of TranscriptReader, see editor/transcriptreader.h,
+// on synthetic transcripts of the given sizes (10k, 100k and 1M words by
+// default) or on transcript files.
+//
+// Usage: transcriptparsebenchmark [<word count> | <transcript.xml>]...
+
+#include "editor/transcriptreader.h"
+#include "editor/timecodec.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+/**
+ * @brief Generates a transcript of `wordCount` timed words.
+ */
+QByteArray syntheticTranscript(int wordCount, int wordsPerLine = 12)
+{
+    static const QByteArray words[] = {"the", "transcript", "of", "a", "recorded", "interview",
+                                       "with", "several", "speakers", "and", "timestamps"};
+
+    QByteArray xml;
+    xml.reserve(qsizetype(wordCount) * 70 + 64);
+    xml.append("<transcript lang=\"english\">\n");
+
+    qint64 milliseconds = 0;
+    for (int i = 0; i < wordCount;) {
+        auto lineTime = TimeCodec::toString(milliseconds).toLatin1();
+        xml.append("<line timestamp=\"").append(lineTime).append("\" speaker=\"Speaker ")
+           .append(QByteArray::number(i / wordsPerLine % 4)).append("\">\n");
+        for (int j = 0; j < wordsPerLine && i < wordCount; j++, i++) {
+            milliseconds += 350;
+            auto wordTime = TimeCodec::toString(milliseconds).toLatin1();
+            xml.append("<word timestamp=\"").append(wordTime).append("\"")
+               .append(i % 50 ? "" : " tags=\"noise\"").append(" isEdited=\"false\">")
+               .append(words[i % std::size(words)]).append("</word>\n");
+        }
+        xml.append("</line>\n");
+    }
+    xml.append("</transcript>\n");
+    return xml;
+}
+
+bool benchmark(const QString& name, QByteArray xml)
+{
+    QBuffer buffer(&xml);
+    buffer.open(QIODevice::ReadOnly);
+
+    QElapsedTimer timer;
+    timer.start();
+    TranscriptReader reader(&buffer);
+    auto blocks = reader.readAll();
+    double seconds = qMax<qint64>(timer.nsecsElapsed(), 1) / 1e9;
+
+    if (reader.hasError()) {
+        std::cerr << name.toStdString() << ": " << reader.errorString().toStdString() << std::endl;
+        return false;
+    }
+
+    qsizetype words = 0;
+    for (auto& a_block: std::as_const(blocks))
+        words += a_block.wordCount();
+
+    std::cout << name.toStdString() << ": " << words << " words, "
+              << QString::number(xml.size() / 1e6 / seconds, 'f', 1).toStdString() << " MB/s, "
+              << QString::number(words / seconds, 'f', 0).toStdString() << " words/s" << std::endl;
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QStringList arguments;
+    for (int i = 1; i < argc; i++)
+        arguments << QFile::decodeName(argv[i]);
+    if (arguments.isEmpty())
+        arguments << "10000" << "100000" << "1000000";
+
+    bool succeeded = true;
+    for (auto& argument: std::as_const(arguments)) {
+        bool isCount = false;
+        int wordCount = argument.toInt(&isCount);
+        if (isCount) {
+            succeeded &= benchmark("synthetic", syntheticTranscript(wordCount));
+            continue;
+        }
+
+        QFile file(argument);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::cerr << "Couldn't read " << argument.toStdString() << std::endl;
+            succeeded = false;
+            continue;
+        }
+        succeeded &= benchmark(argument, file.readAll());
+    }
+    return succeeded ? 0 : 1;
+}
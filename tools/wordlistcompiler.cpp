@@ -0,0 +1,33 @@
+// Compiles a plain text wordlist (one word per line, UTF-8) into the sorted
+// string table read by WordList, see editor/wordlist.h.
+//
+// Usage: wordlistcompiler <wordlist.txt> <wordlist.vwl>
+
+#include "editor/wordlist.h"
+
+#include <QFile>
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        std::cerr << "Usage: wordlistcompiler <wordlist.txt> <wordlist.vwl>" << std::endl;
+        return 1;
+    }
+
+    auto input = QFile::decodeName(argv[1]);
+    auto output = QFile::decodeName(argv[2]);
+
+    auto words = WordList::fromFile(input);
+    if (words.isEmpty()) {
+        std::cerr << "Couldn't read any words from " << argv[1] << std::endl;
+        return 1;
+    }
+    if (!words.save(output)) {
+        std::cerr << "Couldn't write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::cout << argv[2] << ": " << words.size() << " words" << std::endl;
+    return 0;
+}